@@ -0,0 +1,280 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "archive.hh"
+
+using namespace archive;
+using namespace chess;
+
+static const char MAGIC[8] = {'L', 'U', 'S', 'H', 'A', 'R', 'C', 'H'};
+static constexpr uint32_t VERSION = 1;
+static constexpr size_t HEADER_SIZE = 32;
+static constexpr size_t GAME_HEADER_SIZE = 4;
+
+static constexpr int SPECIAL_SHIFT = 12;
+static constexpr uint16_t PROMOTION_KIND_MASK = 3;
+
+static_assert(sizeof(archive::Move) == 2, "moves have to fit 16 bits");
+
+static void fail_with_message(const char *funcname, const char *path, const char *message)
+{
+	fprintf(stderr, "lushin: archive: %s: %s: %s\n", funcname, path, message);
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_message(path, message) fail_with_message(__func__, path, message)
+
+static uint16_t cell(const Pos &pos)
+{
+	return static_cast<uint16_t>(pos.x + 8 * pos.y);
+}
+
+static Pos pos_of(uint16_t cell)
+{
+	return Pos(static_cast<int>(cell % 8), static_cast<int>(cell / 8));
+}
+
+archive::Move archive::encode(const chess::Move &move, Special special, Kind promotion)
+{
+	uint16_t flags = static_cast<uint16_t>(special);
+
+	if (special == Special::Promotion) {
+		assert(promotion != Kind::King && promotion != Kind::Pawn);
+		flags |= static_cast<uint16_t>(promotion) - static_cast<uint16_t>(Kind::Queen);
+	}
+
+	return static_cast<archive::Move>(cell(move.from) | cell(move.to) << 6 | flags << SPECIAL_SHIFT);
+}
+
+chess::Move archive::decode(archive::Move move)
+{
+	return chess::Move{pos_of(move & 63), pos_of(move >> 6 & 63)};
+}
+
+void archive::apply(Board &board, archive::Move move)
+{
+	const chess::Move decoded = archive::decode(move);
+	const uint16_t flags = move >> SPECIAL_SHIFT;
+
+	if (flags & static_cast<uint16_t>(Special::Promotion)) {
+		const Color color = board.at(decoded.from).color;
+		const Kind kind = static_cast<Kind>(static_cast<uint16_t>(Kind::Queen) + (flags & PROMOTION_KIND_MASK));
+
+		board.set(decoded.from, Piece::that_is_not_present());
+		board.set(decoded.to, Piece(color, kind));
+		return;
+	}
+
+	if (flags == static_cast<uint16_t>(Special::Castling)) {
+		// the rook jumps from its corner to the other side
+		// of the king
+		const bool short_side = decoded.to.x > decoded.from.x;
+		const Pos rook_from(short_side ? 7 : 0, static_cast<int>(decoded.from.y));
+		const Pos rook_to(short_side ? 5 : 3, static_cast<int>(decoded.from.y));
+
+		board.set(rook_to, board.at(rook_from));
+		board.set(rook_from, Piece::that_is_not_present());
+	} else if (flags == static_cast<uint16_t>(Special::EnPassant)) {
+		board.set(Pos(static_cast<int>(decoded.to.x), static_cast<int>(decoded.from.y)), Piece::that_is_not_present());
+	}
+
+	board.set(decoded.to, board.at(decoded.from));
+	board.set(decoded.from, Piece::that_is_not_present());
+}
+
+static void put_u16(uint8_t *bytes, uint16_t value)
+{
+	bytes[0] = static_cast<uint8_t>(value);
+	bytes[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static void put_u32(uint8_t *bytes, uint32_t value)
+{
+	put_u16(bytes, static_cast<uint16_t>(value));
+	put_u16(bytes + 2, static_cast<uint16_t>(value >> 16));
+}
+
+static void put_u64(uint8_t *bytes, uint64_t value)
+{
+	put_u32(bytes, static_cast<uint32_t>(value));
+	put_u32(bytes + 4, static_cast<uint32_t>(value >> 32));
+}
+
+static uint32_t read_u32(const uint8_t *bytes)
+{
+	return static_cast<uint32_t>(bytes[0]) |
+	       static_cast<uint32_t>(bytes[1]) << 8 |
+	       static_cast<uint32_t>(bytes[2]) << 16 |
+	       static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+static uint64_t read_u64(const uint8_t *bytes)
+{
+	return read_u32(bytes) | static_cast<uint64_t>(read_u32(bytes + 4)) << 32;
+}
+
+Writer::Writer(const char *path) : m_path(path), m_offset(HEADER_SIZE)
+{
+	if (!(this->m_file = fopen(path, "wb"))) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	// the header gets filled in by finish
+	const uint8_t header[HEADER_SIZE] = {};
+
+	if (fwrite(header, sizeof(header), 1, this->m_file) != 1) {
+		fail_with_message(path, strerror(errno));
+	}
+}
+
+Writer::~Writer()
+{
+	if (this->m_file) {
+		fclose(this->m_file);
+	}
+}
+
+void Writer::add(Result result, const archive::Move *moves, size_t nmoves)
+{
+	assert(nmoves <= MAX_MOVES);
+
+	uint8_t header[GAME_HEADER_SIZE] = {};
+
+	put_u16(header, static_cast<uint16_t>(nmoves));
+	header[2] = static_cast<uint8_t>(result);
+
+	// moves get written as they are in memory, which is little
+	// endian on every machine we run on
+	if (fwrite(header, sizeof(header), 1, this->m_file) != 1 ||
+	    fwrite(moves, sizeof(archive::Move), nmoves, this->m_file) != nmoves) {
+		fail_with_message(this->m_path, strerror(errno));
+	}
+
+	this->m_offsets.push_back(this->m_offset);
+	this->m_offset += sizeof(header) + nmoves * sizeof(archive::Move);
+}
+
+void Writer::finish()
+{
+	const uint8_t padding[8] = {};
+	const size_t npadding = (8 - this->m_offset % 8) % 8;
+	const uint64_t index_offset = this->m_offset + npadding;
+
+	uint8_t header[HEADER_SIZE] = {};
+
+	memcpy(header, MAGIC, sizeof(MAGIC));
+	put_u32(header + 8, VERSION);
+	put_u64(header + 16, this->m_offsets.size());
+	put_u64(header + 24, index_offset);
+
+	bool ok = fwrite(padding, 1, npadding, this->m_file) == npadding;
+
+	for (uint64_t offset : this->m_offsets) {
+		uint8_t bytes[8];
+		put_u64(bytes, offset);
+		ok = ok && fwrite(bytes, sizeof(bytes), 1, this->m_file) == 1;
+	}
+
+	ok = ok && fseek(this->m_file, 0, SEEK_SET) == 0;
+	ok = ok && fwrite(header, sizeof(header), 1, this->m_file) == 1;
+
+	if (fclose(this->m_file)) {
+		ok = false;
+	}
+
+	this->m_file = nullptr;
+
+	if (!ok) {
+		fail_with_message(this->m_path, strerror(errno));
+	}
+}
+
+size_t Writer::size() const
+{
+	return this->m_offsets.size();
+}
+
+Reader::Reader(const char *path)
+{
+	int fd;
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	this->m_size = static_cast<size_t>(st.st_size);
+
+	if (this->m_size < HEADER_SIZE) {
+		fail_with_message(path, "not an archive");
+	}
+
+	void *mapped = mmap(nullptr, this->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (mapped == MAP_FAILED) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	close(fd);
+
+	this->m_data = static_cast<const uint8_t *>(mapped);
+
+	if (memcmp(this->m_data, MAGIC, sizeof(MAGIC))) {
+		fail_with_message(path, "not an archive");
+	}
+
+	if (read_u32(this->m_data + 8) != VERSION) {
+		fail_with_message(path, "unknown archive version");
+	}
+
+	this->m_ngames = read_u64(this->m_data + 16);
+	const uint64_t index_offset = read_u64(this->m_data + 24);
+
+	if (index_offset % 8 || index_offset > this->m_size ||
+	    this->m_ngames > (this->m_size - index_offset) / sizeof(uint64_t)) {
+		fail_with_message(path, "index does not fit the file");
+	}
+
+	this->m_index = reinterpret_cast<const uint64_t *>(this->m_data + index_offset);
+
+	for (size_t i = 0; i < this->m_ngames; ++i) {
+		const uint64_t offset = this->m_index[i];
+
+		if (offset % 2 || offset + GAME_HEADER_SIZE > index_offset ||
+		    offset + GAME_HEADER_SIZE + this->game(i).nmoves * sizeof(archive::Move) > index_offset) {
+			fail_with_message(path, "game does not fit the file");
+		}
+	}
+}
+
+Reader::~Reader()
+{
+	munmap(const_cast<uint8_t *>(this->m_data), this->m_size);
+}
+
+size_t Reader::size() const
+{
+	return this->m_ngames;
+}
+
+Game Reader::game(size_t idx) const
+{
+	assert(idx < this->m_ngames);
+
+	const uint8_t *bytes = this->m_data + this->m_index[idx];
+
+	return Game{
+		static_cast<Result>(bytes[2]),
+		reinterpret_cast<const archive::Move *>(bytes + GAME_HEADER_SIZE),
+		static_cast<size_t>(bytes[0] | bytes[1] << 8)
+	};
+}
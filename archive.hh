@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "chess.hh"
+
+//
+// Compact binary game archive.
+//
+// Games are stored as their moves from the initial board, 16 bits
+// each, so that reading them back takes no parsing. An archive
+// file is laid out as
+//
+//   header   8 bytes "LUSHARCH", uint32 version, uint32 zero,
+//            uint64 number of games, uint64 offset of the index
+//   games    per game uint16 number of moves, uint8 Result,
+//            uint8 zero, then the moves
+//   index    uint64 file offset of each game, 8 byte aligned
+//
+// with all numbers little endian. Reader maps the file into
+// memory and hands out games right from the mapping.
+//
+
+namespace archive
+{
+	/**
+	 * A move packed into 16 bits: bits 0-5 hold the from cell
+	 * (x + 8 * y), bits 6-11 the to cell and bits 12-15 the
+	 * Special flags.
+	 */
+	using Move = uint16_t;
+
+	/**
+	 * Moves that do more than move one piece. The move generator
+	 * knows none of these, but games played elsewhere use them.
+	 */
+	enum class Special : uint8_t
+	{
+		None = 0,
+
+		// from and to are those of the king; the rook moves
+		// along
+		Castling = 1,
+
+		// the pawn taken is the one next to from, on the
+		// column of to
+		EnPassant = 2,
+
+		// the pawn turns into the kind given by the lower two
+		// bits, see encode
+		Promotion = 4
+	};
+
+	/**
+	 * How a game ended, from the result tag or the end of the
+	 * movetext.
+	 */
+	enum class Result : uint8_t
+	{
+		Unknown = 0,
+		WhiteWins = 1,
+		BlackWins = 2,
+		Draw = 3
+	};
+
+	/**
+	 * Pack move. promotion is only looked at for
+	 * Special::Promotion and must be Queen, Rook, Bishop or
+	 * Knight.
+	 */
+	Move encode(const chess::Move &move, Special special = Special::None,
+	            chess::Kind promotion = chess::Kind::Queen);
+
+	/**
+	 * Return the from and to cells of move.
+	 */
+	chess::Move decode(Move move);
+
+	/**
+	 * Do move on board, including whatever else it does
+	 * besides moving one piece.
+	 */
+	void apply(chess::Board &board, Move move);
+
+	/**
+	 * A game in an archive. moves points into the mapped file.
+	 */
+	struct Game
+	{
+		Result result;
+		const Move *moves;
+		size_t nmoves;
+	};
+
+	/**
+	 * Writes an archive file one game at a time. The index gets
+	 * written by finish, so without it the file is not usable.
+	 * Exits the program if the file can not be written.
+	 */
+	class Writer
+	{
+	public:
+		explicit Writer(const char *path);
+		~Writer();
+
+		Writer(const Writer &other) = delete;
+		Writer &operator=(const Writer &other) = delete;
+
+		/**
+		 * Append a game with result and nmoves moves.
+		 */
+		void add(Result result, const Move *moves, size_t nmoves);
+
+		/**
+		 * Write the index and header and close the file.
+		 */
+		void finish();
+
+		/**
+		 * Return the number of games added.
+		 */
+		size_t size() const;
+
+	private:
+		const char *m_path;
+		FILE *m_file;
+		uint64_t m_offset;
+		std::vector<uint64_t> m_offsets;
+	};
+
+	/**
+	 * Maps an archive file into memory. Exits the program if the
+	 * file can not be read or is not an archive.
+	 */
+	class Reader
+	{
+	public:
+		explicit Reader(const char *path);
+		~Reader();
+
+		Reader(const Reader &other) = delete;
+		Reader &operator=(const Reader &other) = delete;
+
+		/**
+		 * Return the number of games in the archive.
+		 */
+		size_t size() const;
+
+		/**
+		 * Return game idx, which must be less than size. Does
+		 * not copy anything.
+		 */
+		Game game(size_t idx) const;
+
+	private:
+		const uint8_t *m_data;
+		size_t m_size;
+		const uint64_t *m_index;
+		size_t m_ngames;
+	};
+
+	/**
+	 * Longest game an archive can hold, in plies.
+	 */
+	static constexpr size_t MAX_MOVES = UINT16_MAX;
+};
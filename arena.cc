@@ -0,0 +1,160 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+#include "arena.hh"
+
+using namespace arena;
+using namespace chess;
+
+static void fail_with_message(const char *funcname, const char *message)
+{
+	fprintf(stderr, "lushin: arena: %s: %s\n", funcname, message);
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_message(message) fail_with_message(__func__, message)
+
+//
+// MoveList
+//
+
+MoveList::MoveList(Move *data, size_t size) : m_data(data), m_size(size)
+{
+}
+
+Move *MoveList::begin() const
+{
+	return this->m_data;
+}
+
+Move *MoveList::end() const
+{
+	return this->m_data + this->m_size;
+}
+
+size_t MoveList::size() const
+{
+	return this->m_size;
+}
+
+bool MoveList::empty() const
+{
+	return this->m_size == 0;
+}
+
+Move &MoveList::operator[](size_t idx) const
+{
+	assert(idx < this->m_size);
+	return this->m_data[idx];
+}
+
+//
+// Stack
+//
+
+Stack::Stack() : m_top(0), m_ply(0)
+{
+	if (!(this->m_memory = static_cast<uint8_t *>(malloc(CAPACITY)))) {
+		fail_with_message("could not allocate stack memory");
+	}
+}
+
+Stack::~Stack()
+{
+	free(this->m_memory);
+}
+
+size_t Stack::ply() const
+{
+	return this->m_ply;
+}
+
+size_t Stack::used() const
+{
+	return this->m_top;
+}
+
+void *Stack::allocate(size_t size, size_t alignment)
+{
+	const uintptr_t base = reinterpret_cast<uintptr_t>(this->m_memory);
+	const uintptr_t unaligned = base + this->m_top;
+	const uintptr_t aligned = (unaligned + alignment - 1) & ~(alignment - 1);
+	const size_t new_top = (aligned - base) + size;
+
+	if (new_top > CAPACITY) {
+		fail_with_message("out of stack memory");
+	}
+
+	this->m_top = new_top;
+	return reinterpret_cast<void *>(aligned);
+}
+
+Stack &arena::local()
+{
+	static thread_local Stack stack;
+	return stack;
+}
+
+//
+// Frame
+//
+
+Frame::Frame(Stack &stack) : m_stack(stack), m_top(stack.m_top), m_ply(stack.m_ply), m_made(false)
+{
+	if (this->m_ply >= MAX_PLY) {
+		fail_with_message("too many nested plies");
+	}
+
+	this->m_stack.m_ply += 1;
+}
+
+Frame::~Frame()
+{
+	assert(this->m_stack.m_ply == this->m_ply + 1);
+
+	this->m_stack.m_top = this->m_top;
+	this->m_stack.m_ply = this->m_ply;
+}
+
+size_t Frame::ply() const
+{
+	return this->m_ply;
+}
+
+MoveList Frame::moves(const Board &board, Color current_player, Targets targets)
+{
+	// reserve for the worst case, then give back what was not
+	// needed; this works as long as this is the most recent
+	// allocation on the stack
+
+	Move *buf = this->scratch<Move>(MAX_NEXT_MOVES);
+	const size_t nmoves = chess::next_moves(board, current_player, buf, targets);
+
+	const uint8_t *used_end = reinterpret_cast<uint8_t *>(buf + nmoves);
+	this->m_stack.m_top = used_end - this->m_stack.m_memory;
+
+	return MoveList(buf, nmoves);
+}
+
+std::optional<Piece> Frame::make(Board &board, const Move &move)
+{
+	assert(!this->m_made);
+
+	Undo &undo = this->m_stack.m_undos[this->m_ply];
+	undo.move = move;
+	undo.captured = board.move(move.from, move.to);
+
+	this->m_made = true;
+	return undo.captured;
+}
+
+void Frame::unmake(Board &board)
+{
+	assert(this->m_made);
+
+	const Undo &undo = this->m_stack.m_undos[this->m_ply];
+	board.unmove(undo.move.from, undo.move.to, undo.captured);
+
+	this->m_made = false;
+}
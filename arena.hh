@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "chess.hh"
+
+namespace arena
+{
+	/**
+	 * Maximum number of nested frames, that is the deepest
+	 * ply a search can reach.
+	 */
+	static constexpr size_t MAX_PLY = 128;
+
+	/**
+	 * Size of the memory block backing the frames of one thread
+	 * in bytes.
+	 */
+	static constexpr size_t CAPACITY = 1024 * 1024;
+
+	/**
+	 * Everything needed to take back a move done with
+	 * Board::move.
+	 */
+	struct Undo
+	{
+		chess::Move move;
+		std::optional<chess::Piece> captured;
+	};
+
+	/**
+	 * A list of moves that lives in a Frame. It stays valid
+	 * until the Frame it came from goes out of scope.
+	 */
+	class MoveList
+	{
+	public:
+		MoveList(chess::Move *data, size_t size);
+
+		chess::Move *begin() const;
+		chess::Move *end() const;
+
+		size_t size() const;
+		bool empty() const;
+
+		chess::Move &operator[](size_t idx) const;
+
+	private:
+		chess::Move *m_data;
+		size_t m_size;
+	};
+
+	/**
+	 * Memory for the frames of one thread. It gets allocated
+	 * once when the thread first uses it. After that, entering
+	 * and leaving frames never calls the global allocator.
+	 */
+	class Stack
+	{
+	public:
+		Stack();
+		~Stack();
+
+		Stack(const Stack &other) = delete;
+		Stack &operator=(const Stack &other) = delete;
+
+		/**
+		 * Return the number of frames currently entered.
+		 */
+		size_t ply() const;
+
+		/**
+		 * Return the number of bytes currently in use.
+		 */
+		size_t used() const;
+
+	private:
+		friend class Frame;
+
+		uint8_t *m_memory;
+		size_t m_top;
+		size_t m_ply;
+		Undo m_undos[MAX_PLY];
+
+		void *allocate(size_t size, size_t alignment);
+	};
+
+	/**
+	 * Return the Stack of the calling thread.
+	 */
+	Stack &local();
+
+	/**
+	 * The memory of one search ply. Everything handed out by a
+	 * Frame is released in O(1) when the Frame goes out of
+	 * scope. Frames have to be destroyed in reverse order of
+	 * creation, which is what happens naturally when they live
+	 * on the call stack.
+	 */
+	class Frame
+	{
+	public:
+		/**
+		 * Enter a new frame on stack.
+		 */
+		explicit Frame(Stack &stack = local());
+
+		/**
+		 * Leave the frame, releasing all memory it handed out.
+		 */
+		~Frame();
+
+		Frame(const Frame &other) = delete;
+		Frame &operator=(const Frame &other) = delete;
+
+		/**
+		 * Return the ply of this frame, starting at 0 for the
+		 * outermost frame.
+		 */
+		size_t ply() const;
+
+		/**
+		 * Return the moves current_player can do on board,
+		 * limited to targets.
+		 */
+		MoveList moves(const chess::Board &board, chess::Color current_player, chess::Targets targets = chess::Targets::All);
+
+		/**
+		 * Do move on board and remember what is needed to undo it.
+		 * Each frame holds one undo record; the move has to be
+		 * taken back with unmake before the next make.
+		 */
+		std::optional<chess::Piece> make(chess::Board &board, const chess::Move &move);
+
+		/**
+		 * Take back the move done in the last call to make.
+		 */
+		void unmake(chess::Board &board);
+
+		/**
+		 * Return uninitialized room for n objects of type T. No
+		 * destructors are run when the frame is left.
+		 */
+		template <typename T>
+		T *scratch(size_t n)
+		{
+			void *memory = m_stack.allocate(n * sizeof(T), alignof(T));
+			return static_cast<T *>(memory);
+		}
+
+	private:
+		Stack &m_stack;
+		size_t m_top;
+		size_t m_ply;
+		bool m_made;
+	};
+};
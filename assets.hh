@@ -5,50 +5,65 @@
 
 namespace assets
 {
-	extern "C"
-	{
-		extern uint8_t binary_bishop_black_png[] asm("_binary___assets_bishop_black_png_start");
-		extern uint8_t binary_bishop_black_png_end[] asm("_binary___assets_bishop_black_png_end");
-
-		extern uint8_t binary_bishop_white_png[] asm("_binary___assets_bishop_white_png_start");
-		extern uint8_t binary_bishop_white_png_end[] asm("_binary___assets_bishop_white_png_end");
-
-		extern uint8_t binary_king_black_png[] asm("_binary___assets_king_black_png_start");
-		extern uint8_t binary_king_black_png_end[] asm("_binary___assets_king_black_png_end");
-
-		extern uint8_t binary_king_white_png[] asm("_binary___assets_king_white_png_start");
-		extern uint8_t binary_king_white_png_end[] asm("_binary___assets_king_white_png_end");
+	/**
+	 * Width and height of a single piece in the atlas in pixels.
+	 */
+	static constexpr int PIECE_DIM = 64;
 
-		extern uint8_t binary_knight_black_png[] asm("_binary___assets_knight_black_png_start");
-		extern uint8_t binary_knight_black_png_end[] asm("_binary___assets_knight_black_png_end");
+	/**
+	 * The atlas has one column per kind of piece and one row
+	 * per color, in the order of the chess::Kind and chess::Color
+	 * enums.
+	 */
+	static constexpr int ATLAS_COLUMNS = 6;
+	static constexpr int ATLAS_ROWS = 2;
 
-		extern uint8_t binary_knight_white_png[] asm("_binary___assets_knight_white_png_start");
-		extern uint8_t binary_knight_white_png_end[] asm("_binary___assets_knight_white_png_end");
+	static constexpr int ATLAS_WIDTH = ATLAS_COLUMNS * PIECE_DIM;
+	static constexpr int ATLAS_HEIGHT = ATLAS_ROWS * PIECE_DIM;
 
-		extern uint8_t binary_pawn_black_png[] asm("_binary___assets_pawn_black_png_start");
-		extern uint8_t binary_pawn_black_png_end[] asm("_binary___assets_pawn_black_png_end");
+	/**
+	 * Bytes per pixel of the atlas. Pixels are stored as R, G, B
+	 * and A bytes, row by row, without any padding.
+	 */
+	static constexpr int ATLAS_BYTES_PER_PIXEL = 4;
 
-		extern uint8_t binary_pawn_white_png[] asm("_binary___assets_pawn_white_png_start");
-		extern uint8_t binary_pawn_white_png_end[] asm("_binary___assets_pawn_white_png_end");
+	extern "C"
+	{
+		// created at build time by pack_assets from the PNGs
+		// in ./assets
+		extern uint8_t binary_atlas_rgba[] asm("_binary_atlas_rgba_start");
+		extern uint8_t binary_atlas_rgba_end[] asm("_binary_atlas_rgba_end");
+	}
 
-		extern uint8_t binary_queen_black_png[] asm("_binary___assets_queen_black_png_start");
-		extern uint8_t binary_queen_black_png_end[] asm("_binary___assets_queen_black_png_end");
+	/**
+	 * Convert the staticly compiled atlas into an SDL texture.
+	 *
+	 * Quits the program on errors.
+	 */
+	SDL_Texture *load_atlas();
 
-		extern uint8_t binary_queen_white_png[] asm("_binary___assets_queen_white_png_start");
-		extern uint8_t binary_queen_white_png_end[] asm("_binary___assets_queen_white_png_end");
+	/**
+	 * Size of a character of the built-in font in pixels, not
+	 * counting any space between characters.
+	 */
+	static constexpr int GLYPH_WIDTH = 5;
+	static constexpr int GLYPH_HEIGHT = 7;
 
-		extern uint8_t binary_rook_black_png[] asm("_binary___assets_rook_black_png_start");
-		extern uint8_t binary_rook_black_png_end[] asm("_binary___assets_rook_black_png_end");
+	/**
+	 * The font has the printable ASCII characters, from ' ' to
+	 * '~', side by side in a single row.
+	 */
+	static constexpr char FONT_FIRST = ' ';
+	static constexpr int FONT_GLYPHS = '~' - ' ' + 1;
 
-		extern uint8_t binary_rook_white_png[] asm("_binary___assets_rook_white_png_start");
-		extern uint8_t binary_rook_white_png_end[] asm("_binary___assets_rook_white_png_end");
-	}
+	static constexpr int FONT_WIDTH = FONT_GLYPHS * GLYPH_WIDTH;
+	static constexpr int FONT_HEIGHT = GLYPH_HEIGHT;
 
 	/**
-	 * Convert one of the staticly compiled PNG assets into an SDL
-	 * texture.
+	 * Turn the built-in font into an SDL texture of white
+	 * characters on a transparent background.
 	 *
 	 * Quits the program on errors.
 	 */
-	SDL_Texture *load_texture(uint8_t *startptr, uint8_t *endptr);
+	SDL_Texture *load_font();
 }
@@ -0,0 +1,225 @@
+#include <array>
+
+#include "attacks.hh"
+#include "weights.hh"
+
+using namespace chess;
+using namespace attacks;
+
+static constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+static constexpr uint64_t FILE_H = FILE_A << 7;
+
+static int popcount(uint64_t mask)
+{
+	return __builtin_popcountll(mask);
+}
+
+/**
+ * Return the cells reached from (x, y) with one of the steps in
+ * deltas, which are pairs of x and y offsets.
+ */
+template <size_t N>
+static std::array<uint64_t, 64> make_step_table(const int (&deltas)[N][2])
+{
+	std::array<uint64_t, 64> table = {};
+
+	for (int i = 0; i < 64; ++i) {
+		for (const auto &delta : deltas) {
+			const int x = i % 8 + delta[0];
+			const int y = i / 8 + delta[1];
+
+			if (x >= 0 && x < 8 && y >= 0 && y < 8) {
+				table[i] |= 1ULL << (x + 8 * y);
+			}
+		}
+	}
+
+	return table;
+}
+
+static constexpr int KNIGHT_STEPS[8][2] = {
+	{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+};
+
+static constexpr int KING_STEPS[8][2] = {
+	{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}
+};
+
+// straight steps first, then diagonal ones
+static constexpr int RAY_STEPS[8][2] = {
+	{1, 0}, {0, 1}, {-1, 0}, {0, -1}, {1, 1}, {-1, 1}, {-1, -1}, {1, -1}
+};
+
+static const std::array<uint64_t, 64> KNIGHT_ATTACKS = make_step_table(KNIGHT_STEPS);
+static const std::array<uint64_t, 64> KING_ATTACKS = make_step_table(KING_STEPS);
+
+/**
+ * For each of RAY_STEPS and each cell, all cells reached by
+ * repeating the step until the edge of the board.
+ */
+static const std::array<std::array<uint64_t, 64>, 8> RAYS = [] {
+	std::array<std::array<uint64_t, 64>, 8> rays = {};
+
+	for (size_t r = 0; r < 8; ++r) {
+		for (int i = 0; i < 64; ++i) {
+			int x = i % 8 + RAY_STEPS[r][0];
+			int y = i / 8 + RAY_STEPS[r][1];
+
+			for (; x >= 0 && x < 8 && y >= 0 && y < 8; x += RAY_STEPS[r][0], y += RAY_STEPS[r][1]) {
+				rays[r][i] |= 1ULL << (x + 8 * y);
+			}
+		}
+	}
+
+	return rays;
+}();
+
+/**
+ * Return the cells attacked from cell i along rays [begin, end),
+ * each of which ends at the first occupied cell.
+ */
+static uint64_t slide(int i, size_t begin, size_t end, uint64_t occupied)
+{
+	uint64_t mask = 0;
+
+	for (size_t r = begin; r < end; ++r) {
+		const uint64_t ray = RAYS[r][i];
+		const uint64_t blockers = ray & occupied;
+
+		if (!blockers) {
+			mask |= ray;
+			continue;
+		}
+
+		// the nearest blocker has the lowest bit on rays going
+		// to higher cells and the highest bit on the others
+		const bool up = RAY_STEPS[r][0] + 8 * RAY_STEPS[r][1] > 0;
+		const int nearest = up ? __builtin_ctzll(blockers) : 63 - __builtin_clzll(blockers);
+
+		mask |= ray ^ RAYS[r][nearest];
+	}
+
+	return mask;
+}
+
+/**
+ * Return the cells attacked by the pawns of color. White moves up
+ * (towards y = 0), Black moves down.
+ */
+static uint64_t pawn_attacks(uint64_t pawns, Color color)
+{
+	if (color == Color::White) {
+		return ((pawns & ~FILE_A) >> 9) | ((pawns & ~FILE_H) >> 7);
+	}
+
+	return ((pawns & ~FILE_A) << 7) | ((pawns & ~FILE_H) << 9);
+}
+
+static uint64_t piece_attacks(Kind kind, int i, uint64_t occupied)
+{
+	switch (kind) {
+	case Kind::King:
+		return KING_ATTACKS[i];
+	case Kind::Queen:
+		return slide(i, 0, 8, occupied);
+	case Kind::Rook:
+		return slide(i, 0, 4, occupied);
+	case Kind::Bishop:
+		return slide(i, 4, 8, occupied);
+	case Kind::Knight:
+		return KNIGHT_ATTACKS[i];
+	case Kind::Pawn:
+		break;
+	}
+
+	return 0;
+}
+
+Map attacks::compute(const Board &board)
+{
+	Map map = {};
+
+	for (Color color : {Color::White, Color::Black}) {
+		const size_t c = static_cast<size_t>(color);
+
+		for (size_t k = 0; k < 6; ++k) {
+			map.pieces[c][k] = board.mask(color, static_cast<Kind>(k));
+			map.occupied[c] |= map.pieces[c][k];
+		}
+	}
+
+	const uint64_t occupied = map.occupied[0] | map.occupied[1];
+	const size_t pawn = static_cast<size_t>(Kind::Pawn);
+
+	for (Color color : {Color::White, Color::Black}) {
+		const size_t c = static_cast<size_t>(color);
+		map.by_kind[c][pawn] = pawn_attacks(map.pieces[c][pawn], color);
+	}
+
+	for (Color color : {Color::White, Color::Black}) {
+		const size_t c = static_cast<size_t>(color);
+		const uint64_t safe = ~map.occupied[c] & ~map.by_kind[static_cast<size_t>(swap_color(color))][pawn];
+
+		for (size_t k = 0; k < pawn; ++k) {
+			for (uint64_t pieces = map.pieces[c][k]; pieces; pieces &= pieces - 1) {
+				const uint64_t attacked = piece_attacks(static_cast<Kind>(k), __builtin_ctzll(pieces), occupied);
+
+				map.by_kind[c][k] |= attacked;
+				map.mobility[c][k] += popcount(attacked & safe);
+			}
+		}
+
+		for (size_t k = 0; k <= pawn; ++k) {
+			map.all[c] |= map.by_kind[c][k];
+		}
+	}
+
+	return map;
+}
+
+Terms attacks::count_terms(const Map &map, Color color)
+{
+	const size_t own = static_cast<size_t>(color);
+	const size_t theirs = static_cast<size_t>(swap_color(color));
+	const uint64_t their_king = map.pieces[theirs][static_cast<size_t>(Kind::King)];
+
+	Terms terms = {};
+
+	uint64_t zone = their_king;
+
+	if (their_king) {
+		zone |= KING_ATTACKS[__builtin_ctzll(their_king)];
+	}
+
+	for (size_t k = 0; k < 6; ++k) {
+		terms.mobility[k] = map.mobility[own][k];
+		terms.king_attacks[k] = popcount(map.by_kind[own][k] & zone);
+	}
+
+	const uint64_t pieces = map.occupied[own] & ~map.pieces[own][static_cast<size_t>(Kind::King)];
+	terms.hanging = popcount(pieces & map.all[theirs] & ~map.all[own]);
+
+	return terms;
+}
+
+/**
+ * Return the score of the attack terms of color.
+ */
+static int evaluate_color(const Map &map, Color color)
+{
+	const Terms terms = attacks::count_terms(map, color);
+
+	int score = -terms.hanging * weights::HANGING_PENALTY;
+
+	for (size_t k = 0; k < 6; ++k) {
+		score += terms.mobility[k] * weights::MOBILITY_BONUS[k];
+		score += terms.king_attacks[k] * weights::KING_ATTACK_BONUS[k];
+	}
+
+	return score;
+}
+
+int attacks::evaluate(const Map &map)
+{
+	return evaluate_color(map, Color::White) - evaluate_color(map, Color::Black);
+}
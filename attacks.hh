@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+#include "chess.hh"
+
+//
+// Attack maps: which cells each kind of piece of each color
+// attacks, as bitboards (bit x + 8 * y, like pawns::Entry). They
+// are built once per evaluation straight from the board, without
+// the move generator, and every term that needs to know about
+// attacks reads them with popcounts.
+//
+
+namespace attacks
+{
+	/**
+	 * Pieces and the cells they attack. Arrays are indexed by
+	 * color and then by chess::Kind.
+	 */
+	struct Map
+	{
+		uint64_t pieces[2][6];
+		uint64_t occupied[2];
+
+		// cells attacked by at least one piece of the kind
+		uint64_t by_kind[2][6];
+		uint64_t all[2];
+
+		// for each kind, the sum over its pieces of the cells
+		// they attack that are neither taken by their own side
+		// nor attacked by enemy pawns
+		int mobility[2][6];
+	};
+
+	/**
+	 * How often each attack term applies to one color.
+	 */
+	struct Terms
+	{
+		// indexed by chess::Kind, see Map::mobility
+		int mobility[6];
+
+		// indexed by chess::Kind: number of cells next to the
+		// enemy king (or under it) that the kind attacks
+		int king_attacks[6];
+
+		// pieces other than the king that the enemy attacks
+		// and nothing defends
+		int hanging;
+	};
+
+	/**
+	 * Build the attack map of board.
+	 */
+	Map compute(const chess::Board &board);
+
+	/**
+	 * Count the terms for color.
+	 */
+	Terms count_terms(const Map &map, chess::Color color);
+
+	/**
+	 * Score the attack terms in centipawns from the point of view
+	 * of White.
+	 */
+	int evaluate(const Map &map);
+};
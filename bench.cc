@@ -0,0 +1,367 @@
+//
+// Microbenchmarks for the core primitives.
+//
+// usage: lushin-bench [--cpu N] [NAME...]
+//
+// Runs each primitive over a fixed set of positions until the
+// timing is stable and prints the results as JSON on stdout. If
+// any NAME is given, only benchmarks with those names run.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sched.h>
+#include <string>
+#include <vector>
+
+#include "chess.hh"
+#include "choice.hh"
+#include "evalcache.hh"
+#include "search.hh"
+#include "tt.hh"
+
+using namespace chess;
+
+/**
+ * Positions every benchmark runs on.
+ */
+static const char *CORPUS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w",
+	"r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w",
+	"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w",
+	"r2q1rk1/1b2bppp/p2ppn2/1p6/3NP3/1BN1B3/PPP2PPP/R2Q1RK1 b",
+	"2r2rk1/pp3ppp/2n1b3/3p4/3P4/2PB1N2/P4PPP/R4RK1 w",
+	"8/5pk1/6p1/3R4/7P/6P1/r4PK1/8 b",
+	"8/8/4k3/8/2p5/8/B2K4/8 w",
+	"4k3/8/8/8/8/8/4P3/4K3 w",
+};
+
+/**
+ * The search shuffles moves; seed it the same way every run so
+ * that runs can be compared.
+ */
+static constexpr uint64_t SEED = 1;
+
+/**
+ * A benchmark has been stable once the relative standard deviation
+ * of the last WINDOW batches is below this.
+ */
+static constexpr double STABLE_RSD = 0.01;
+static constexpr size_t WINDOW = 5;
+
+/**
+ * Give up on stability after this many batches or this much time.
+ */
+static constexpr size_t MAX_BATCHES = 200;
+static constexpr double MAX_SECONDS = 10.0;
+
+/**
+ * Target duration of a single batch.
+ */
+static constexpr double BATCH_SECONDS = 0.05;
+
+/**
+ * Results get added to this so that the compiler can not throw
+ * away the work we want to measure.
+ */
+static volatile uint64_t sink;
+
+struct Benchmark
+{
+	const char *name;
+
+	// run the primitive once on each position, return the number
+	// of operations done
+	uint64_t (*run)(const std::vector<Position> &);
+};
+
+struct Measurement
+{
+	double ns_per_op;
+	double stddev_ns;
+	double rsd;
+	size_t batches;
+	uint64_t ops_per_batch;
+	bool stable;
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+	const auto now = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(now - start).count();
+}
+
+static void pin_to_cpu(int cpu)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+
+	if (sched_setaffinity(0, sizeof(set), &set)) {
+		perror("sched_setaffinity");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static double mean_of(const double *values, size_t n)
+{
+	double sum = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+		sum += values[i];
+	}
+
+	return sum / n;
+}
+
+static double stddev_of(const double *values, size_t n, double mean)
+{
+	double sum = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+		sum += (values[i] - mean) * (values[i] - mean);
+	}
+
+	return std::sqrt(sum / n);
+}
+
+static Measurement measure(const Benchmark &benchmark, const std::vector<Position> &corpus)
+{
+	// find out how many rounds fill one batch
+	uint64_t rounds = 1;
+
+	for (;;) {
+		const auto start = std::chrono::steady_clock::now();
+
+		for (uint64_t i = 0; i < rounds; ++i) {
+			benchmark.run(corpus);
+		}
+
+		if (seconds_since(start) >= BATCH_SECONDS / 4 || rounds >= (1u << 30)) {
+			const double per_round = seconds_since(start) / rounds;
+			rounds = std::max<uint64_t>(1, static_cast<uint64_t>(BATCH_SECONDS / per_round));
+			break;
+		}
+
+		rounds *= 2;
+	}
+
+	// run batches until the last few agree with each other
+
+	std::vector<double> samples;
+	Measurement result = {};
+	const auto start = std::chrono::steady_clock::now();
+
+	while (samples.size() < MAX_BATCHES && seconds_since(start) < MAX_SECONDS) {
+		uint64_t ops = 0;
+		const auto batch_start = std::chrono::steady_clock::now();
+
+		for (uint64_t i = 0; i < rounds; ++i) {
+			ops += benchmark.run(corpus);
+		}
+
+		const double seconds = seconds_since(batch_start);
+		samples.push_back(seconds * 1e9 / ops);
+		result.ops_per_batch = ops;
+
+		if (samples.size() >= WINDOW) {
+			const double *window = samples.data() + samples.size() - WINDOW;
+			const double mean = mean_of(window, WINDOW);
+			const double stddev = stddev_of(window, WINDOW, mean);
+
+			result.ns_per_op = mean;
+			result.stddev_ns = stddev;
+			result.rsd = stddev / mean;
+
+			if (result.rsd < STABLE_RSD) {
+				result.stable = true;
+				break;
+			}
+		}
+	}
+
+	result.batches = samples.size();
+
+	if (samples.size() < WINDOW) {
+		result.ns_per_op = mean_of(samples.data(), samples.size());
+		result.stddev_ns = stddev_of(samples.data(), samples.size(), result.ns_per_op);
+		result.rsd = result.stddev_ns / result.ns_per_op;
+	}
+
+	return result;
+}
+
+//
+// the benchmarks
+//
+
+static uint64_t run_valid_next_positions(const std::vector<Position> &corpus)
+{
+	uint64_t ops = 0;
+
+	for (const Position &position : corpus) {
+		for (uint8_t x = 0; x < 8; ++x) {
+			for (uint8_t y = 0; y < 8; ++y) {
+				const Pos from = {x, y};
+
+				if (!position.board.at(from).present) {
+					continue;
+				}
+
+				sink += chess::valid_next_positions(position.board, from).size();
+				ops += 1;
+			}
+		}
+	}
+
+	return ops;
+}
+
+static uint64_t run_valid_next_boards(const std::vector<Position> &corpus)
+{
+	for (const Position &position : corpus) {
+		sink += chess::valid_next_boards(position.board, position.current_player).size();
+	}
+
+	return corpus.size();
+}
+
+static uint64_t run_next_moves(const std::vector<Position> &corpus)
+{
+	Move moves[MAX_NEXT_MOVES];
+
+	for (const Position &position : corpus) {
+		sink += chess::next_moves(position.board, position.current_player, moves);
+	}
+
+	return corpus.size();
+}
+
+static uint64_t run_score(const std::vector<Position> &corpus)
+{
+	for (const Position &position : corpus) {
+		sink += chess::score(position.board, position.current_player);
+	}
+
+	return corpus.size();
+}
+
+static uint64_t run_is_checked(const std::vector<Position> &corpus)
+{
+	for (const Position &position : corpus) {
+		sink += chess::is_checked(position.board, position.current_player);
+	}
+
+	return corpus.size();
+}
+
+static uint64_t run_is_check_mated(const std::vector<Position> &corpus)
+{
+	for (const Position &position : corpus) {
+		sink += chess::is_check_mated(position.board, position.current_player);
+	}
+
+	return corpus.size();
+}
+
+static uint64_t run_search(const std::vector<Position> &corpus)
+{
+	// the computer thinks for a fixed amount of time, which is
+	// useless for measuring; run the same search to a fixed depth
+	// with a fresh table instead
+
+	static tt::Table table(1);
+	static evalcache::Cache eval_cache(1);
+	static choice::Generator generator(SEED);
+	static search::Search searcher(table, eval_cache, generator);
+
+	const search::Limits limits = {3, 0};
+
+	// the same shuffle every round, so every round does the
+	// same work
+	generator = choice::Generator(SEED);
+
+	for (const Position &position : corpus) {
+		table.clear();
+		eval_cache.clear();
+		const search::Result result = searcher.run(position.board, position.current_player, limits);
+		sink += result.nodes;
+	}
+
+	return corpus.size();
+}
+
+static const Benchmark BENCHMARKS[] = {
+	{"valid_next_positions", run_valid_next_positions},
+	{"valid_next_boards", run_valid_next_boards},
+	{"next_moves", run_next_moves},
+	{"score", run_score},
+	{"is_checked", run_is_checked},
+	{"is_check_mated", run_is_check_mated},
+	{"search_depth_3", run_search},
+};
+
+static bool is_selected(const char *name, const std::vector<std::string> &filter)
+{
+	if (filter.empty()) {
+		return true;
+	}
+
+	return std::find(filter.begin(), filter.end(), name) != filter.end();
+}
+
+int main(int argc, char **argv)
+{
+	int cpu = 0;
+	std::vector<std::string> filter;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--cpu") && i + 1 < argc) {
+			cpu = atoi(argv[++i]);
+		} else if (argv[i][0] == '-') {
+			fprintf(stderr, "usage: %s [--cpu N] [NAME...]\n", argv[0]);
+			exit(EXIT_FAILURE);
+		} else {
+			filter.push_back(argv[i]);
+		}
+	}
+
+	// keep the scheduler from moving us around between cores
+	pin_to_cpu(cpu);
+	choice::seed(SEED);
+
+	std::vector<Position> corpus;
+
+	for (const char *fen : CORPUS) {
+		corpus.push_back(chess::parse_fen(fen));
+	}
+
+	printf("{\n");
+	printf("  \"cpu\": %d,\n", cpu);
+	printf("  \"positions\": %zu,\n", corpus.size());
+	printf("  \"results\": [");
+
+	bool first = true;
+
+	for (const Benchmark &benchmark : BENCHMARKS) {
+		if (!is_selected(benchmark.name, filter)) {
+			continue;
+		}
+
+		const Measurement m = measure(benchmark, corpus);
+
+		printf("%s\n    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"stddev_ns\": %.2f, \"rsd\": %.4f, "
+		       "\"batches\": %zu, \"ops_per_batch\": %llu, \"stable\": %s}",
+		       first ? "" : ",", benchmark.name, m.ns_per_op, m.stddev_ns, m.rsd,
+		       m.batches, static_cast<unsigned long long>(m.ops_per_batch), m.stable ? "true" : "false");
+
+		fflush(stdout);
+		first = false;
+	}
+
+	printf("\n  ]\n}\n");
+}
@@ -3,6 +3,7 @@
 #include <cassert>
 
 #include "chess.hh"
+#include "nnue.hh"
 
 static constexpr uint8_t ROWS = 8;
 static constexpr uint8_t COLUMNS = 8;
@@ -11,12 +12,18 @@ using namespace chess;
 
 Board::Board()
 {
-	const size_t num_cells = ROWS * COLUMNS;
+	// board is kept in a fixed size array so that copying or
+	// creating boards never has to allocate
 
-	for (size_t i = 0; i < num_cells; ++i) {
-		Piece not_present = Piece::that_is_not_present();
-		this->mboard.push_back(not_present);
+	this->mboard.fill(Piece::that_is_not_present());
+	this->mhash = 0;
+	this->mpawn_hash = 0;
+
+	for (auto &masks : this->mmasks) {
+		masks.fill(0);
 	}
+
+	nnue::reset(this->maccumulator);
 }
 
 static size_t get_idx_for(uint8_t x, uint8_t y)
@@ -27,7 +34,7 @@ static size_t get_idx_for(uint8_t x, uint8_t y)
 	return idx;
 }
 
-Piece &Board::at(const Pos &pos)
+Piece &Board::mutable_at(const Pos &pos)
 {
 	const size_t idx = get_idx_for(pos.x, pos.y);
 	return this->mboard.at(idx);
@@ -39,6 +46,59 @@ const Piece &Board::at(const Pos &pos) const
 	return this->mboard.at(idx);
 }
 
+void Board::set(const Pos &pos, const Piece &piece)
+{
+	Piece &target = this->mutable_at(pos);
+
+	if (target.present) {
+		const uint64_t key = zobrist_key(pos, target);
+
+		this->mhash ^= key;
+
+		if (target.kind == Kind::Pawn) {
+			this->mpawn_hash ^= key;
+		}
+
+		nnue::remove(this->maccumulator, pos, target);
+		this->mmasks[static_cast<size_t>(target.color)][static_cast<size_t>(target.kind)] ^= pos.bit();
+	}
+
+	if (piece.present) {
+		const uint64_t key = zobrist_key(pos, piece);
+
+		this->mhash ^= key;
+
+		if (piece.kind == Kind::Pawn) {
+			this->mpawn_hash ^= key;
+		}
+
+		nnue::add(this->maccumulator, pos, piece);
+		this->mmasks[static_cast<size_t>(piece.color)][static_cast<size_t>(piece.kind)] ^= pos.bit();
+	}
+
+	target = piece;
+}
+
+uint64_t Board::hash() const
+{
+	return this->mhash;
+}
+
+uint64_t Board::pawn_hash() const
+{
+	return this->mpawn_hash;
+}
+
+const Accumulator &Board::accumulator() const
+{
+	return this->maccumulator;
+}
+
+uint64_t Board::mask(Color color, Kind kind) const
+{
+	return this->mmasks[static_cast<size_t>(color)][static_cast<size_t>(kind)];
+}
+
 void Board::for_each(const std::function<void(const Pos &pos, const Piece &piece)> &f) const
 {
 	for (uint8_t x = 0; x < 8; ++x) {
@@ -61,8 +121,8 @@ std::optional<Piece> Board::move(const Pos &from, const Pos &to)
 	const Piece captured = this->at(to);
 	assert(!captured.present || can_take_place_of(capturer, captured));
 
-	this->at(from) = Piece::that_is_not_present();
-	this->at(to) = capturer;
+	this->set(from, Piece::that_is_not_present());
+	this->set(to, capturer);
 
 	if (captured.present) {
 		return std::make_optional(captured);
@@ -71,45 +131,60 @@ std::optional<Piece> Board::move(const Pos &from, const Pos &to)
 	}
 }
 
+void Board::unmove(const Pos &from, const Pos &to, const std::optional<Piece> &captured)
+{
+	const Piece mover = this->at(to);
+	assert(mover.present);
+	assert(!this->at(from).present);
+
+	this->set(from, mover);
+
+	if (captured) {
+		this->set(to, *captured);
+	} else {
+		this->set(to, Piece::that_is_not_present());
+	}
+}
+
 Board Board::initial()
 {
 	Board b;
 
-	b.at({0, 0}) = Piece{Color::Black, Kind::Rook};
-	b.at({1, 0}) = Piece{Color::Black, Kind::Knight};
-	b.at({2, 0}) = Piece{Color::Black, Kind::Bishop};
-	b.at({3, 0}) = Piece{Color::Black, Kind::Queen};
-	b.at({4, 0}) = Piece{Color::Black, Kind::King};
-	b.at({5, 0}) = Piece{Color::Black, Kind::Bishop};
-	b.at({6, 0}) = Piece{Color::Black, Kind::Knight};
-	b.at({7, 0}) = Piece{Color::Black, Kind::Rook};
-
-	b.at({0, 1}) = Piece{Color::Black, Kind::Pawn};
-	b.at({1, 1}) = Piece{Color::Black, Kind::Pawn};
-	b.at({2, 1}) = Piece{Color::Black, Kind::Pawn};
-	b.at({3, 1}) = Piece{Color::Black, Kind::Pawn};
-	b.at({4, 1}) = Piece{Color::Black, Kind::Pawn};
-	b.at({5, 1}) = Piece{Color::Black, Kind::Pawn};
-	b.at({6, 1}) = Piece{Color::Black, Kind::Pawn};
-	b.at({7, 1}) = Piece{Color::Black, Kind::Pawn};
-
-	b.at({0, 6}) = Piece{Color::White, Kind::Pawn};
-	b.at({1, 6}) = Piece{Color::White, Kind::Pawn};
-	b.at({2, 6}) = Piece{Color::White, Kind::Pawn};
-	b.at({3, 6}) = Piece{Color::White, Kind::Pawn};
-	b.at({4, 6}) = Piece{Color::White, Kind::Pawn};
-	b.at({5, 6}) = Piece{Color::White, Kind::Pawn};
-	b.at({6, 6}) = Piece{Color::White, Kind::Pawn};
-	b.at({7, 6}) = Piece{Color::White, Kind::Pawn};
-
-	b.at({0, 7}) = Piece{Color::White, Kind::Rook};
-	b.at({1, 7}) = Piece{Color::White, Kind::Knight};
-	b.at({2, 7}) = Piece{Color::White, Kind::Bishop};
-	b.at({3, 7}) = Piece{Color::White, Kind::Queen};
-	b.at({4, 7}) = Piece{Color::White, Kind::King};
-	b.at({5, 7}) = Piece{Color::White, Kind::Bishop};
-	b.at({6, 7}) = Piece{Color::White, Kind::Knight};
-	b.at({7, 7}) = Piece{Color::White, Kind::Rook};
+	b.set({0, 0}, Piece{Color::Black, Kind::Rook});
+	b.set({1, 0}, Piece{Color::Black, Kind::Knight});
+	b.set({2, 0}, Piece{Color::Black, Kind::Bishop});
+	b.set({3, 0}, Piece{Color::Black, Kind::Queen});
+	b.set({4, 0}, Piece{Color::Black, Kind::King});
+	b.set({5, 0}, Piece{Color::Black, Kind::Bishop});
+	b.set({6, 0}, Piece{Color::Black, Kind::Knight});
+	b.set({7, 0}, Piece{Color::Black, Kind::Rook});
+
+	b.set({0, 1}, Piece{Color::Black, Kind::Pawn});
+	b.set({1, 1}, Piece{Color::Black, Kind::Pawn});
+	b.set({2, 1}, Piece{Color::Black, Kind::Pawn});
+	b.set({3, 1}, Piece{Color::Black, Kind::Pawn});
+	b.set({4, 1}, Piece{Color::Black, Kind::Pawn});
+	b.set({5, 1}, Piece{Color::Black, Kind::Pawn});
+	b.set({6, 1}, Piece{Color::Black, Kind::Pawn});
+	b.set({7, 1}, Piece{Color::Black, Kind::Pawn});
+
+	b.set({0, 6}, Piece{Color::White, Kind::Pawn});
+	b.set({1, 6}, Piece{Color::White, Kind::Pawn});
+	b.set({2, 6}, Piece{Color::White, Kind::Pawn});
+	b.set({3, 6}, Piece{Color::White, Kind::Pawn});
+	b.set({4, 6}, Piece{Color::White, Kind::Pawn});
+	b.set({5, 6}, Piece{Color::White, Kind::Pawn});
+	b.set({6, 6}, Piece{Color::White, Kind::Pawn});
+	b.set({7, 6}, Piece{Color::White, Kind::Pawn});
+
+	b.set({0, 7}, Piece{Color::White, Kind::Rook});
+	b.set({1, 7}, Piece{Color::White, Kind::Knight});
+	b.set({2, 7}, Piece{Color::White, Kind::Bishop});
+	b.set({3, 7}, Piece{Color::White, Kind::Queen});
+	b.set({4, 7}, Piece{Color::White, Kind::King});
+	b.set({5, 7}, Piece{Color::White, Kind::Bishop});
+	b.set({6, 7}, Piece{Color::White, Kind::Knight});
+	b.set({7, 7}, Piece{Color::White, Kind::Rook});
 
 	return b;
 }
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <optional>
 #include <ostream>
+#include <string>
 #include <vector>
 
 namespace chess
@@ -44,6 +47,11 @@ namespace chess
 		Kind kind;
 		bool present;
 
+		/**
+		 * Construct a piece that is not present.
+		 */
+		Piece();
+
 		/**
 		 * Copy constructor.
 		 */
@@ -144,6 +152,85 @@ namespace chess
 		 * are in [0, 7].
 		 */
 		bool on_board() const;
+
+		/**
+		 * Return a mask with only the bit for this Pos set,
+		 * that is bit x + 8 * y.
+		 */
+		uint64_t bit() const;
+	};
+
+	/**
+	 * A move of whatever piece is on from to position to.
+	 */
+	struct Move
+	{
+		Pos from;
+		Pos to;
+
+		/**
+		 * Equality check.
+		 */
+		bool operator==(const Move &other) const;
+
+		/**
+		 * Unequality check.
+		 */
+		bool operator!=(const Move &other) const;
+	};
+
+	/**
+	 * Upper bound on the number of positions a single piece can
+	 * reach within one turn. A queen in the center of an empty
+	 * board has the most options.
+	 */
+	static constexpr size_t MAX_NEXT_POSITIONS = 27;
+
+	/**
+	 * Upper bound on the number of moves one player can have
+	 * on any board.
+	 */
+	static constexpr size_t MAX_NEXT_MOVES = 512;
+
+	/**
+	 * Which kind of moves to generate: all of them, only the
+	 * ones that take a piece or only the ones that do not.
+	 */
+	enum class Targets : uint8_t
+	{
+		All = 0,
+		Captures = 1,
+		Quiets = 2
+	};
+
+	/**
+	 * Return the Zobrist key of piece standing on pos. The hash
+	 * of a board is the XOR of the keys of all its present pieces.
+	 */
+	uint64_t zobrist_key(const Pos &pos, const Piece &piece);
+
+	/**
+	 * Return the Zobrist key for current_player being the one to
+	 * move. Hash tables that care about whose turn it is XOR this
+	 * into the board hash.
+	 */
+	uint64_t zobrist_key(Color current_player);
+
+	/**
+	 * Number of neurons in the first layer of the neural
+	 * evaluation for each side, see nnue.hh.
+	 */
+	static constexpr size_t NNUE_HIDDEN = 64;
+
+	/**
+	 * Output of the first layer of the neural evaluation, once
+	 * from the point of view of each color. Board keeps it up
+	 * to date as pieces come and go.
+	 */
+	struct Accumulator
+	{
+		// indexed by color
+		alignas(32) int16_t values[2][NNUE_HIDDEN];
 	};
 
 	/**
@@ -158,14 +245,40 @@ namespace chess
 		Board();
 
 		/**
-		 * Return a pointer to the piece at pos.
+		 * Return a reference to the piece at pos.
 		 */
-		Piece &at(const Pos &pos);
+		const Piece &at(const Pos &pos) const;
 
 		/**
-		 * Return a reference to the piece at pos.
+		 * Put piece on pos, replacing whatever was there before.
 		 */
-		const Piece &at(const Pos &pos) const;
+		void set(const Pos &pos, const Piece &piece);
+
+		/**
+		 * Return the Zobrist hash of the pieces on this board.
+		 * It is kept up to date by set, move and unmove.
+		 */
+		uint64_t hash() const;
+
+		/**
+		 * Return the Zobrist hash of only the pawns on this
+		 * board, kept up to date the same way as hash.
+		 */
+		uint64_t pawn_hash() const;
+
+		/**
+		 * Return the first layer of the neural evaluation for
+		 * this board, kept up to date the same way as hash.
+		 */
+		const Accumulator &accumulator() const;
+
+		/**
+		 * Return the cells (bit x + 8 * y, see Pos::bit) with a
+		 * piece of color and kind, kept up to date the same way
+		 * as hash.
+		 */
+		uint64_t mask(Color color, Kind kind) const;
+
 		/**
 		 * Run f on each present piece on the board.
 		 */
@@ -177,6 +290,12 @@ namespace chess
 		 */
 		std::optional<Piece> move(const Pos &from, const Pos &to);
 
+		/**
+		 * Take back a move from -> to that returned captured
+		 * when it was passed to move.
+		 */
+		void unmove(const Pos &from, const Pos &to, const std::optional<Piece> &captured);
+
 		/**
 		 * Create a new board with the inital game set. Black is
 		 * on top, White on the bottom.
@@ -185,9 +304,51 @@ namespace chess
 
 	private:
 		// 8 x 8 board
-		std::vector<Piece> mboard;
+		std::array<Piece, 64> mboard;
+
+		// zobrist hash of mboard
+		uint64_t mhash;
+
+		// zobrist hash of the pawns in mboard
+		uint64_t mpawn_hash;
+
+		// first layer of the neural evaluation of mboard
+		Accumulator maccumulator;
+
+		// cells of the pieces in mboard, indexed by color and
+		// kind
+		std::array<std::array<uint64_t, 6>, 2> mmasks;
+
+		Piece &mutable_at(const Pos &pos);
 	};
 
+	/**
+	 * A board together with whose turn it is.
+	 */
+	struct Position
+	{
+		Board board;
+		Color current_player;
+	};
+
+	/**
+	 * Parse the piece placement and active color fields of a
+	 * FEN string. Remaining fields are ignored. Throws
+	 * std::invalid_argument if fen is malformed.
+	 */
+	Position parse_fen(const std::string &fen);
+
+	/**
+	 * Return board with current_player to move as FEN string.
+	 */
+	std::string to_fen(const Board &board, Color current_player);
+
+	/**
+	 * Return move as the names of its from and to cells, like
+	 * e2e4.
+	 */
+	std::string format_move(const Move &move);
+
 	/**
 	 * Return whether from can take the place of to.
 	 */
@@ -201,16 +362,32 @@ namespace chess
 	std::vector<Pos> valid_next_positions(const Board &board, const Pos &from);
 
 	/**
-	 * Return all possible follow up states for board when it is
-	 * current_players turn.
+	 * Like valid_next_positions, but write the positions into out
+	 * and return how many were written. out has to have room for
+	 * at least MAX_NEXT_POSITIONS entries. This function does not
+	 * allocate.
 	 */
-	std::vector<Board> valid_next_boards(const Board &board, Color current_player);
+	size_t next_positions(const Board &board, const Pos &from, Pos *out, Targets targets = Targets::All);
 
 	/**
-	 * Given a board, do a move on current_players behaf and
-	 * return the resulting state.
+	 * Write all moves current_player can do on board into out and
+	 * return how many were written. out has to have room for at
+	 * least MAX_NEXT_MOVES entries. This function does not allocate.
 	 */
-	Board best_next_board(const Board &board, Color current_player);
+	size_t next_moves(const Board &board, Color current_player, Move *out, Targets targets = Targets::All);
+
+	/**
+	 * Return whether move is one of the moves current_player can
+	 * do on board. Cheaper than generating all moves when only a
+	 * single candidate needs checking.
+	 */
+	bool is_valid_move(const Board &board, Color current_player, const Move &move);
+
+	/**
+	 * Return all possible follow up states for board when it is
+	 * current_players turn.
+	 */
+	std::vector<Board> valid_next_boards(const Board &board, Color current_player);
 
 	/**
 	 * Return wheter board is in a state of "checked" when it is
@@ -231,8 +408,47 @@ namespace chess
 	bool is_check_mated(const Board &board, Color current_player);
 
 	/**
-	 * Score board from the point of view of current_player. The
-	 * higher the score, the better.
+	 * All moves possible on one board, computed once so that
+	 * looking them up later is cheap.
+	 */
+	struct MoveTable
+	{
+		// for each cell x + 8 * y, the cells the piece on it
+		// can move to as bit mask (see Pos::bit)
+		uint64_t destinations[64];
+
+		// whether the player to move is checked
+		bool checked;
+
+		// whether the player to move is check mated
+		bool check_mated;
+
+		/**
+		 * Return the cells the piece on from can move to as
+		 * bit mask.
+		 */
+		uint64_t destinations_from(const Pos &from) const;
+
+		/**
+		 * Return whether the piece on from can move to to.
+		 */
+		bool allows(const Pos &from, const Pos &to) const;
+	};
+
+	/**
+	 * Compute the MoveTable for board when it is current_players
+	 * turn. Destinations are listed for the pieces of both players.
+	 */
+	MoveTable move_table(const Board &board, Color current_player);
+
+	/**
+	 * Return the material value of a piece of kind in centipawns.
+	 */
+	int piece_value(Kind kind);
+
+	/**
+	 * Score board from the point of view of current_player in
+	 * centipawns. The higher the score, the better.
 	 */
 	int score(const Board &board, Color current_player);
 };
@@ -245,4 +461,5 @@ std::ostream &operator<<(std::ostream &os, const chess::Color &color);
 std::ostream &operator<<(std::ostream &os, const chess::Kind &kind);
 std::ostream &operator<<(std::ostream &os, const chess::Piece &piece);
 std::ostream &operator<<(std::ostream &os, const chess::Pos &pos);
+std::ostream &operator<<(std::ostream &os, const chess::Move &move);
 std::ostream &operator<<(std::ostream &os, const chess::Board &board);
@@ -1,12 +1,124 @@
+#include <atomic>
+#include <cstdlib>
 #include <ctime>
 
 #include "choice.hh"
 
-void choice::ensure_initialized()
+using namespace choice;
+
+/**
+ * Seed the generator of a thread gets derived from, together
+ * with the number of generators created before it.
+ */
+static std::atomic<uint64_t> base_seed;
+static std::atomic<bool> base_seed_set;
+static std::atomic<uint64_t> ngenerators;
+
+static uint64_t splitmix64(uint64_t &state)
+{
+	state += 0x9e3779b97f4a7c15ULL;
+
+	uint64_t z = state;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t default_seed()
+{
+	if (const char *env = getenv("LUSHIN_SEED")) {
+		return strtoull(env, nullptr, 0);
+	}
+
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * Return the seed for the next generator that gets created.
+ */
+static uint64_t next_thread_seed()
 {
-	static bool initialized = false;
+	if (!base_seed_set.load(std::memory_order_acquire)) {
+		// if two threads get here at once, the first one wins
+		uint64_t expected = 0;
+		base_seed.compare_exchange_strong(expected, default_seed() | 1);
+		base_seed_set.store(true, std::memory_order_release);
+	}
 
-	if (!initialized) {
-		srand(time(NULL));
+	uint64_t state = base_seed.load(std::memory_order_relaxed);
+	state += ngenerators.fetch_add(1, std::memory_order_relaxed) * 0xd1b54a32d192ed03ULL;
+
+	return splitmix64(state);
+}
+
+Generator::Generator(uint64_t seed)
+{
+	// xoshiro must not start out all zeros; splitmix64 never
+	// gives four zeros in a row
+	for (uint64_t &word : this->m_state) {
+		word = splitmix64(seed);
 	}
 }
+
+uint64_t Generator::next()
+{
+	uint64_t *s = this->m_state;
+
+	const uint64_t result = rotl(s[1] * 5, 7) * 9;
+	const uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+
+	return result;
+}
+
+uint64_t Generator::below(uint64_t bound)
+{
+	// Lemire's method: the high half of a 128 bit product is
+	// uniform once the few low halves that would make some
+	// results more likely are thrown away
+
+	unsigned __int128 product = static_cast<unsigned __int128>(this->next()) * bound;
+	uint64_t low = static_cast<uint64_t>(product);
+
+	if (low < bound) {
+		const uint64_t threshold = -bound % bound;
+
+		while (low < threshold) {
+			product = static_cast<unsigned __int128>(this->next()) * bound;
+			low = static_cast<uint64_t>(product);
+		}
+	}
+
+	return static_cast<uint64_t>(product >> 64);
+}
+
+Generator &choice::local()
+{
+	static thread_local Generator generator(next_thread_seed());
+	return generator;
+}
+
+void choice::seed(uint64_t seed)
+{
+	base_seed.store(seed, std::memory_order_relaxed);
+	base_seed_set.store(true, std::memory_order_release);
+	ngenerators.store(0, std::memory_order_relaxed);
+
+	local() = Generator(seed);
+}
@@ -1,12 +1,56 @@
 #pragma once
 
-#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <utility>
 #include <vector>
 
 namespace choice
 {
-	void ensure_initialized();
+	/**
+	 * A xoshiro256** pseudo random number generator. Small and
+	 * fast; not suited for anything that needs to be secure.
+	 */
+	class Generator
+	{
+	public:
+		/**
+		 * Create a new generator. Equal seeds give equal
+		 * sequences.
+		 */
+		explicit Generator(uint64_t seed);
+
+		/**
+		 * Return the next 64 random bits.
+		 */
+		uint64_t next();
+
+		/**
+		 * Return a number in [0, bound), without the bias
+		 * of taking the remainder. bound must not be zero.
+		 */
+		uint64_t below(uint64_t bound);
+
+	private:
+		uint64_t m_state[4];
+	};
+
+	/**
+	 * Return the generator of the calling thread. Every thread
+	 * has its own, so drawing numbers never waits on other
+	 * threads.
+	 */
+	Generator &local();
+
+	/**
+	 * Reseed the generator of the calling thread and set the
+	 * seed that generators of threads started later derive
+	 * theirs from. Without a call to seed, the seed comes from
+	 * the LUSHIN_SEED environment variable or, if that is not
+	 * set, from the clock.
+	 */
+	void seed(uint64_t seed);
 
 	template <typename T>
 	std::optional<T> make(const std::vector<T> &vec)
@@ -15,11 +59,33 @@ namespace choice
 			return std::nullopt;
 		}
 
-		ensure_initialized();
-
-		// this is problematic, but I am too lazy to use
-		// the proper C++ way right now
-		const int idx = random() % vec.size();
+		const size_t idx = local().below(vec.size());
 		return std::make_optional(vec.at(idx));
 	}
+
+	template <typename T>
+	std::optional<T> make(const T *elements, size_t size)
+	{
+		if (size == 0) {
+			return std::nullopt;
+		}
+
+		const size_t idx = local().below(size);
+		return std::make_optional(elements[idx]);
+	}
+
+	template <typename T>
+	void shuffle(Generator &generator, T *elements, size_t size)
+	{
+		for (size_t i = size; i > 1; --i) {
+			const size_t j = generator.below(i);
+			std::swap(elements[i - 1], elements[j]);
+		}
+	}
+
+	template <typename T>
+	void shuffle(T *elements, size_t size)
+	{
+		shuffle(local(), elements, size);
+	}
 };
@@ -0,0 +1,75 @@
+#include <cassert>
+
+#include "engine.hh"
+
+using namespace chess;
+using namespace engine;
+
+Engine::Engine(const Options &options)
+	: m_table(options.table_megabytes), m_eval_cache(options.eval_cache_megabytes),
+	  m_generator(options.seed), m_search(m_table, m_eval_cache, m_generator),
+	  m_position{Board::initial(), Color::White}
+{
+}
+
+void Engine::reset(const Position &position)
+{
+	this->m_position = position;
+	this->m_history.clear();
+	this->m_captured.clear();
+}
+
+void Engine::clear()
+{
+	this->m_table.clear();
+	this->m_eval_cache.clear();
+}
+
+const Board &Engine::board() const
+{
+	return this->m_position.board;
+}
+
+Color Engine::current_player() const
+{
+	return this->m_position.current_player;
+}
+
+const std::vector<Move> &Engine::history() const
+{
+	return this->m_history;
+}
+
+void Engine::play(const Move &move)
+{
+	this->m_captured.push_back(this->m_position.board.move(move.from, move.to));
+	this->m_history.push_back(move);
+	this->m_position.current_player = swap_color(this->m_position.current_player);
+}
+
+bool Engine::undo()
+{
+	if (this->m_history.empty()) {
+		return false;
+	}
+
+	const Move move = this->m_history.back();
+
+	this->m_position.board.unmove(move.from, move.to, this->m_captured.back());
+	this->m_position.current_player = swap_color(this->m_position.current_player);
+
+	this->m_history.pop_back();
+	this->m_captured.pop_back();
+
+	return true;
+}
+
+int Engine::table_permille() const
+{
+	return this->m_table.permille();
+}
+
+search::Result Engine::think(const search::Limits &limits, size_t nlines)
+{
+	return this->m_search.analyze(this->m_position.board, this->m_position.current_player, limits, nlines);
+}
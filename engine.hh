@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "chess.hh"
+#include "choice.hh"
+#include "evalcache.hh"
+#include "search.hh"
+#include "tt.hh"
+
+//
+// One game or analysis session: the position and how it came
+// about, together with everything the computer needs to think
+// about it. All of it lives in the Engine object, so a process
+// can run any number of engines side by side, each on its own
+// thread, without them knowing about each other.
+//
+
+namespace engine
+{
+	struct Options
+	{
+		// size of the transposition table
+		size_t table_megabytes = 16;
+
+		// size of the cache of static scores
+		size_t eval_cache_megabytes = 4;
+
+		// seed of the generator that picks between equally
+		// good moves; engines with equal seeds that get the
+		// same moves and limits think the same way
+		uint64_t seed = 0;
+	};
+
+	/**
+	 * A game and a search to play it. Engines are big (the
+	 * search keeps tables per ply), so they are best kept on
+	 * the heap.
+	 *
+	 * One Engine must only be used by one thread at a time,
+	 * with one exception: while think runs, other threads may
+	 * call the const member functions, as think does not change
+	 * the game.
+	 */
+	class Engine
+	{
+	public:
+		/**
+		 * Create a new engine with the initial board and White
+		 * to move.
+		 */
+		explicit Engine(const Options &options);
+
+		Engine(const Engine &) = delete;
+		Engine &operator=(const Engine &) = delete;
+
+		/**
+		 * Start a new game from position. Forgets the moves
+		 * played so far but keeps what the search learned.
+		 */
+		void reset(const chess::Position &position);
+
+		/**
+		 * Forget everything the search learned, for example
+		 * before analysis that has to be repeatable.
+		 */
+		void clear();
+
+		const chess::Board &board() const;
+
+		chess::Color current_player() const;
+
+		/**
+		 * Return the moves played since the last reset, oldest
+		 * first.
+		 */
+		const std::vector<chess::Move> &history() const;
+
+		/**
+		 * Play move for the player to move. It is your
+		 * responsibility that the move is valid.
+		 */
+		void play(const chess::Move &move);
+
+		/**
+		 * Take back the last move played. Return false if there
+		 * was none.
+		 */
+		bool undo();
+
+		/**
+		 * Search the current position for the nlines best moves
+		 * of the player to move, see search::Search::analyze.
+		 */
+		search::Result think(const search::Limits &limits, size_t nlines = 1);
+
+		/**
+		 * Return how full the transposition table is in
+		 * permille.
+		 */
+		int table_permille() const;
+
+	private:
+		tt::Table m_table;
+		evalcache::Cache m_eval_cache;
+		choice::Generator m_generator;
+		search::Search m_search;
+
+		chess::Position m_position;
+		std::vector<chess::Move> m_history;
+
+		// what each move in m_history took, for undo
+		std::vector<std::optional<chess::Piece>> m_captured;
+	};
+};
@@ -0,0 +1,65 @@
+#include "evalcache.hh"
+
+using namespace evalcache;
+
+/**
+ * Return the largest power of two that is not bigger than n.
+ */
+static size_t floor_power_of_two(size_t n)
+{
+	size_t power = 1;
+
+	while (power * 2 <= n) {
+		power *= 2;
+	}
+
+	return power;
+}
+
+/**
+ * Data of a slot that holds a score. The marker bit keeps filled
+ * slots apart from empty ones, which are all zero.
+ */
+static constexpr uint64_t FILLED = uint64_t(1) << 32;
+
+Cache::Cache(size_t megabytes)
+	: m_slots(floor_power_of_two(megabytes * 1024 * 1024 / sizeof(Slot)))
+{
+}
+
+std::optional<int> Cache::probe(uint64_t key) const
+{
+	const Slot &slot = this->m_slots[key & (this->m_slots.size() - 1)];
+
+	const uint64_t data = slot.data.load(std::memory_order_relaxed);
+	const uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+	if (!(data & FILLED) || (check ^ data) != key) {
+		return std::nullopt;
+	}
+
+	return static_cast<int32_t>(static_cast<uint32_t>(data));
+}
+
+void Cache::store(uint64_t key, int score)
+{
+	Slot &slot = this->m_slots[key & (this->m_slots.size() - 1)];
+
+	const uint64_t data = FILLED | static_cast<uint32_t>(static_cast<int32_t>(score));
+
+	slot.check.store(key ^ data, std::memory_order_relaxed);
+	slot.data.store(data, std::memory_order_relaxed);
+}
+
+void Cache::clear()
+{
+	for (Slot &slot : this->m_slots) {
+		slot.check.store(0, std::memory_order_relaxed);
+		slot.data.store(0, std::memory_order_relaxed);
+	}
+}
+
+size_t Cache::size() const
+{
+	return this->m_slots.size();
+}
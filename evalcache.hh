@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace evalcache
+{
+	/**
+	 * A fixed size, direct mapped cache of static scores. Each
+	 * key maps to exactly one slot; newer scores replace older
+	 * ones.
+	 *
+	 * Threads may share one Cache without locking. A slot keeps
+	 * the key XORed with the data next to the data itself; if
+	 * two threads write a slot at once and the halves get mixed
+	 * up, the key does not check out and the probe misses.
+	 */
+	class Cache
+	{
+	public:
+		/**
+		 * Create a new cache that uses about megabytes of memory.
+		 */
+		explicit Cache(size_t megabytes);
+
+		Cache(const Cache &other) = delete;
+		Cache &operator=(const Cache &other) = delete;
+
+		/**
+		 * Return the score stored for key, if any.
+		 */
+		std::optional<int> probe(uint64_t key) const;
+
+		/**
+		 * Remember score for key.
+		 */
+		void store(uint64_t key, int score);
+
+		/**
+		 * Forget everything stored.
+		 */
+		void clear();
+
+		/**
+		 * Return the number of slots in the cache.
+		 */
+		size_t size() const;
+
+	private:
+		struct Slot
+		{
+			std::atomic<uint64_t> check{0};
+			std::atomic<uint64_t> data{0};
+		};
+
+		std::vector<Slot> m_slots;
+	};
+};
@@ -0,0 +1,164 @@
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+
+#include "chess.hh"
+
+using namespace chess;
+
+//
+// FEN lists the rows from the top (Black) to the bottom (White),
+// which is the same order as our y coordinate.
+//
+
+static Piece piece_for(char c)
+{
+	const Color color = std::isupper(static_cast<unsigned char>(c)) ? Color::White : Color::Black;
+
+	switch (std::tolower(static_cast<unsigned char>(c))) {
+	case 'k':
+		return Piece(color, Kind::King);
+	case 'q':
+		return Piece(color, Kind::Queen);
+	case 'r':
+		return Piece(color, Kind::Rook);
+	case 'b':
+		return Piece(color, Kind::Bishop);
+	case 'n':
+		return Piece(color, Kind::Knight);
+	case 'p':
+		return Piece(color, Kind::Pawn);
+	default:
+		throw std::invalid_argument("bad piece in FEN");
+	}
+}
+
+static char char_for(const Piece &piece)
+{
+	char c;
+
+	switch (piece.kind) {
+	case Kind::King:
+		c = 'k';
+		break;
+	case Kind::Queen:
+		c = 'q';
+		break;
+	case Kind::Rook:
+		c = 'r';
+		break;
+	case Kind::Bishop:
+		c = 'b';
+		break;
+	case Kind::Knight:
+		c = 'n';
+		break;
+	case Kind::Pawn:
+		c = 'p';
+		break;
+	default:
+		throw std::invalid_argument("bad value for Kind enum");
+	}
+
+	if (piece.color == Color::White) {
+		c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+	}
+
+	return c;
+}
+
+Position chess::parse_fen(const std::string &fen)
+{
+	std::istringstream iss(fen);
+	std::string placement;
+	std::string active = "w";
+
+	if (!(iss >> placement)) {
+		throw std::invalid_argument("empty FEN");
+	}
+
+	iss >> active;
+
+	Board board;
+	int x = 0;
+	int y = 0;
+
+	for (const char c : placement) {
+		if (c == '/') {
+			if (x != 8) {
+				throw std::invalid_argument("bad row length in FEN");
+			}
+
+			x = 0;
+			y += 1;
+		} else if (c >= '1' && c <= '8') {
+			x += c - '0';
+		} else {
+			if (x >= 8 || y >= 8) {
+				throw std::invalid_argument("FEN does not fit on board");
+			}
+
+			board.set(Pos(x, y), piece_for(c));
+			x += 1;
+		}
+
+		if (x > 8 || y > 7) {
+			throw std::invalid_argument("FEN does not fit on board");
+		}
+	}
+
+	if (x != 8 || y != 7) {
+		throw std::invalid_argument("FEN has the wrong number of cells");
+	}
+
+	if (active != "w" && active != "b") {
+		throw std::invalid_argument("bad active color in FEN");
+	}
+
+	const Color current_player = active == "w" ? Color::White : Color::Black;
+	return Position {board, current_player};
+}
+
+std::string chess::to_fen(const Board &board, Color current_player)
+{
+	std::string fen;
+
+	for (uint8_t y = 0; y < 8; ++y) {
+		int empty = 0;
+
+		for (uint8_t x = 0; x < 8; ++x) {
+			const Piece &piece = board.at({x, y});
+
+			if (!piece.present) {
+				empty += 1;
+				continue;
+			}
+
+			if (empty) {
+				fen += static_cast<char>('0' + empty);
+				empty = 0;
+			}
+
+			fen += char_for(piece);
+		}
+
+		if (empty) {
+			fen += static_cast<char>('0' + empty);
+		}
+
+		if (y != 7) {
+			fen += '/';
+		}
+	}
+
+	fen += current_player == Color::White ? " w" : " b";
+	return fen;
+}
+
+std::string chess::format_move(const Move &move)
+{
+	return {
+		static_cast<char>('a' + move.from.x), static_cast<char>('8' - move.from.y),
+		static_cast<char>('a' + move.to.x), static_cast<char>('8' - move.to.y)
+	};
+}
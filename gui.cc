@@ -1,18 +1,27 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <climits>
 #include <cstdio>
-#include <cstring>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <signal.h>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include <SDL2/SDL.h>
 
 #include "assets.hh"
 #include "chess.hh"
+#include "choice.hh"
+#include "engine.hh"
 #include "gui.hh"
+#include "record.hh"
+#include "stats.hh"
+#include "timer.hh"
+#include "trace.hh"
 
 //
 // global state of the graphical interface
@@ -20,15 +29,26 @@
 
 static SDL_Window *window;
 static SDL_Renderer *renderer;
-static SDL_Texture *textures[2][6];
+
+/* all pieces in one texture; one row per color, one column per kind */
+static SDL_Texture *atlas;
+
+/* all characters of the built-in font in one texture */
+static SDL_Texture *font;
+
+/* the empty checkerboard, rendered once at startup */
+static SDL_Texture *checkerboard;
+
+/* what is currently on screen; only cells that change get redrawn */
+static SDL_Texture *canvas;
 
 //
 // state that gets written in update() and read in draw()
 //
 
-/* state of the game to display */
-static chess::Board m_board;
-static chess::Color m_current_player;
+/* the game to display; the human always plays White */
+static std::unique_ptr<engine::Engine> m_engine;
+static constexpr chess::Color HUMAN = chess::Color::White;
 
 /* number of the frame currently being rendered */
 static uint32_t m_frame;
@@ -36,7 +56,7 @@ static uint32_t m_frame;
 /* ticks in ms since the start of the game */
 static uint32_t m_ticks;
 
-/* wheter we need to draw anything */
+/* wheter we need to draw all cells, even those that did not change */
 static bool m_dirty;
 
 /* mouse state for the current frame */
@@ -55,18 +75,107 @@ static const chess::Pos *m_hovered_pos;
 /* currently selected piece, might be nullptr */
 static const chess::Piece *m_hovered_piece;
 
-/* supported next moves for m_hovered_piece, might be nulltpr */
-static const std::vector<chess::Pos> *m_valid_next_moves_for_hovered;
+/* cells m_hovered_piece can move to as bit mask, see chess::Pos::bit */
+static uint64_t m_hovered_destinations;
 
 /* currently clicked on cell, might be null */
 static const chess::Pos *m_selected_pos;
 
+/* all moves of HUMAN, recomputed whenever the board changes */
+static chess::MoveTable m_moves;
+
+/* wheter the board changed since the hover suggestions were computed */
+static bool m_board_changed;
+
+/* whether the statistics of the computer are shown over the board */
+static bool m_overlay_visible;
+
+/* lines of text of the overlay */
+static std::string m_overlay_text;
+
+/* whether the overlay needs to be drawn again */
+static bool m_overlay_changed;
+
+//
+// the computer thinks on its own thread so that the interface
+// stays responsive; it reports back with an event
+//
+
+/* type of the event pushed once the computer made its move */
+static uint32_t m_engine_event;
+
+/* thread that computes the move of the computer */
+static std::thread m_engine_thread;
+
+/* wheter the computer is thinking; no input is taken meanwhile */
+static bool m_engine_thinking;
+
+/* what the computer found, written by m_engine_thread */
+static search::Result m_engine_result;
+
+/* set to make the computer stop thinking right away */
+static std::atomic<bool> m_engine_cancel;
+
+/* what the computer found so far, kept up to date while it thinks */
+static search::Progress m_engine_progress;
+
+/* time in ms the computer took for each of its moves */
+static std::vector<uint64_t> m_engine_millis;
+
+/* time in µs the computer took for its last move, for the recording */
+static uint64_t m_engine_micros;
+
+/* how long the computer gets to think about a move */
+static constexpr search::Limits ENGINE_LIMITS = {64, 1000, &m_engine_cancel, &m_engine_progress};
+
+/* the moves of this game, see record.hh */
+static record::Game m_record;
+
+/* file the game gets appended to when it ends; from LUSHIN_RECORD */
+static const char *m_record_path;
+
+/**
+ * Everything that decides what a single cell looks like.
+ */
+struct CellLook
+{
+	bool highlighted;
+	bool selected;
+	bool occupied;
+	chess::Color color;
+	chess::Kind kind;
+};
+
+/* what each cell on canvas currently looks like */
+static CellLook m_drawn_cells[8][8];
+
 //
 // SDL helpers (constants and functions)
 //
 
 #define CELL_DIM 64
 
+/* time in ms the selected cell stays in one state of blinking */
+#define BLINK_MS 250
+
+/* the overlay draws each pixel of the font as a square this big */
+#define TEXT_SCALE 2
+
+/* distance between characters and lines of the overlay in pixels */
+#define TEXT_ADVANCE ((assets::GLYPH_WIDTH + 1) * TEXT_SCALE)
+#define LINE_ADVANCE ((assets::GLYPH_HEIGHT + 3) * TEXT_SCALE)
+
+/* space between the text of the overlay and its edges */
+#define OVERLAY_MARGIN 8
+
+/* most characters on one line of the overlay */
+#define OVERLAY_COLUMNS ((8 * CELL_DIM - 2 * OVERLAY_MARGIN) / TEXT_ADVANCE)
+
+/* time in ms between updates of the overlay while the computer thinks */
+#define OVERLAY_REFRESH_MS 100
+
+static_assert(CELL_DIM == assets::PIECE_DIM, "pieces in the atlas are scaled for CELL_DIM");
+
 static const SDL_Color SDL_BLACK = {
 	0x00, 0x00, 0x00, 0xff
 };
@@ -113,12 +222,38 @@ static void end_drawing()
 	SDL_RenderPresent(renderer);
 }
 
-static void draw_filled_rectangle(uint8_t x, uint8_t y, const SDL_Color &color)
+static void set_render_target(SDL_Texture *texture)
 {
-	const SDL_Rect rectangle = {
+	if (SDL_SetRenderTarget(renderer, texture)) {
+		fail_with_sdl_error();
+	}
+}
+
+static SDL_Texture *create_target_texture()
+{
+	SDL_Texture *texture = SDL_CreateTexture(
+		renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+		8 * CELL_DIM, 8 * CELL_DIM
+	);
+
+	if (!texture) {
+		fail_with_sdl_error();
+	}
+
+	return texture;
+}
+
+static SDL_Rect cell_rectangle(uint8_t x, uint8_t y)
+{
+	return SDL_Rect {
 		x * CELL_DIM, y * CELL_DIM,
 		CELL_DIM, CELL_DIM
 	};
+}
+
+static void draw_filled_rectangle(uint8_t x, uint8_t y, const SDL_Color &color)
+{
+	const SDL_Rect rectangle = cell_rectangle(x, y);
 
 	set_render_color(color);
 
@@ -127,99 +262,157 @@ static void draw_filled_rectangle(uint8_t x, uint8_t y, const SDL_Color &color)
 	}
 }
 
-static SDL_Color blend_average(const SDL_Color &color0, const SDL_Color &color1)
+/**
+ * Draw color at half opacity over cell (x, y), which results in
+ * the average of color and whatever was there before.
+ */
+static void draw_blended_rectangles(const SDL_Rect *rectangles, int count, const SDL_Color &color)
 {
-	const uint16_t r = static_cast<uint16_t>(color0.r) + static_cast<uint16_t>(color1.r);
-	const uint16_t g = static_cast<uint16_t>(color0.g) + static_cast<uint16_t>(color1.g);
-	const uint16_t b = static_cast<uint16_t>(color0.b) + static_cast<uint16_t>(color1.b);
-	const uint16_t a = static_cast<uint16_t>(color0.a) + static_cast<uint16_t>(color1.a);
-
-	const uint8_t rfixed = static_cast<uint8_t>(r / 2);
-	const uint8_t gfixed = static_cast<uint8_t>(g / 2);
-	const uint8_t bfixed = static_cast<uint8_t>(b / 2);
-	const uint8_t afixed = static_cast<uint8_t>(a / 2);
+	if (count == 0) {
+		return;
+	}
 
-	return SDL_Color {
-		rfixed, gfixed, bfixed, afixed
+	const SDL_Color half_transparent = {
+		color.r, color.g, color.b, 0x80
 	};
+
+	set_render_color(half_transparent);
+
+	if (SDL_RenderFillRects(renderer, rectangles, count)) {
+		fail_with_sdl_error();
+	}
 }
 
-//
-// implementation of gui.hh functions
-//
+/* most parts in one batch; enough for the cells or for the overlay */
+#define BATCH_PARTS 512
 
-static SDL_Texture *texture_for(chess::Color color, chess::Kind kind)
+/**
+ * Parts of a texture that get copied to the render target with
+ * a single call to SDL_RenderGeometry.
+ */
+struct Batch
 {
-	const size_t idx0 = static_cast<size_t>(color);
-	const size_t idx1 = static_cast<size_t>(kind);
+	SDL_Vertex vertices[BATCH_PARTS * 4];
+	int indices[BATCH_PARTS * 6];
+	int count;
+};
 
-	return textures[idx0][idx1];
+/**
+ * Add copying srcrect of a texture with given width and height
+ * to dstrect to batch. The texture gets multiplied with color.
+ */
+static void batch_copy(Batch &batch, const SDL_Rect &srcrect, int width, int height, const SDL_Rect &dstrect,
+                       const SDL_Color &color = SDL_WHITE)
+{
+	assert(batch.count < BATCH_PARTS);
+
+	const float u0 = static_cast<float>(srcrect.x) / width;
+	const float v0 = static_cast<float>(srcrect.y) / height;
+	const float u1 = static_cast<float>(srcrect.x + srcrect.w) / width;
+	const float v1 = static_cast<float>(srcrect.y + srcrect.h) / height;
+
+	const float x0 = static_cast<float>(dstrect.x);
+	const float y0 = static_cast<float>(dstrect.y);
+	const float x1 = static_cast<float>(dstrect.x + dstrect.w);
+	const float y1 = static_cast<float>(dstrect.y + dstrect.h);
+
+	SDL_Vertex *vertices = &batch.vertices[batch.count * 4];
+	vertices[0] = SDL_Vertex {{x0, y0}, color, {u0, v0}};
+	vertices[1] = SDL_Vertex {{x1, y0}, color, {u1, v0}};
+	vertices[2] = SDL_Vertex {{x1, y1}, color, {u1, v1}};
+	vertices[3] = SDL_Vertex {{x0, y1}, color, {u0, v1}};
+
+	const int first = batch.count * 4;
+	int *indices = &batch.indices[batch.count * 6];
+	indices[0] = first + 0;
+	indices[1] = first + 1;
+	indices[2] = first + 2;
+	indices[3] = first + 0;
+	indices[4] = first + 2;
+	indices[5] = first + 3;
+
+	batch.count += 1;
 }
 
-static SDL_Texture **texture_ref_for(chess::Color color, chess::Kind kind)
+static void draw_batch(const Batch &batch, SDL_Texture *texture)
 {
-	const size_t idx0 = static_cast<size_t>(color);
-	const size_t idx1 = static_cast<size_t>(kind);
+	if (batch.count == 0) {
+		return;
+	}
 
-	return &textures[idx0][idx1];
+	if (SDL_RenderGeometry(renderer, texture, batch.vertices, batch.count * 4, batch.indices, batch.count * 6)) {
+		fail_with_sdl_error();
+	}
 }
 
-static void load_static_textures()
-{
-	using namespace assets;
-	using namespace chess;
+//
+// implementation of gui.hh functions
+//
 
-	*texture_ref_for(Color::Black, Kind::King) = load_texture(
-		binary_king_black_png, binary_king_black_png_end
-	);
+/**
+ * Return where the piece of color and kind is in the atlas.
+ */
+static SDL_Rect atlas_rectangle(chess::Color color, chess::Kind kind)
+{
+	const int column = static_cast<int>(kind);
+	const int row = static_cast<int>(color);
 
-	*texture_ref_for(Color::Black, Kind::Queen) = load_texture(
-		binary_queen_black_png, binary_queen_black_png_end
-	);
+	return SDL_Rect {
+		column * assets::PIECE_DIM, row * assets::PIECE_DIM,
+		assets::PIECE_DIM, assets::PIECE_DIM
+	};
+}
 
-	*texture_ref_for(Color::Black, Kind::Rook) = load_texture(
-		binary_rook_black_png, binary_rook_black_png_end
-	);
+static void load_static_textures()
+{
+	TRACE_SCOPE("load_static_textures");
 
-	*texture_ref_for(Color::Black, Kind::Knight) = load_texture(
-		binary_knight_black_png, binary_knight_black_png_end
-	);
+	// all pieces come in one texture, already decoded and
+	// scaled to CELL_DIM at build time
+	atlas = assets::load_atlas();
 
-	*texture_ref_for(Color::Black, Kind::Bishop) = load_texture(
-		binary_bishop_black_png, binary_bishop_black_png_end
-	);
+	// the font is tiny, so it gets built at startup
+	font = assets::load_font();
+}
 
-	*texture_ref_for(Color::Black, Kind::Pawn) = load_texture(
-		binary_pawn_black_png, binary_pawn_black_png_end
-	);
+static void render_checkerboard()
+{
+	TRACE_SCOPE("render_checkerboard");
 
-	*texture_ref_for(Color::White, Kind::King) = load_texture(
-		binary_king_white_png, binary_king_white_png_end
-	);
+	static const SDL_Color background_colors[] = {
+		SDL_WHITE, SDL_BLACK
+	};
 
-	*texture_ref_for(Color::White, Kind::Queen) = load_texture(
-		binary_queen_white_png, binary_queen_white_png_end
-	);
+	if (!checkerboard) {
+		checkerboard = create_target_texture();
+	}
 
-	*texture_ref_for(Color::White, Kind::Rook) = load_texture(
-		binary_rook_white_png, binary_rook_white_png_end
-	);
+	set_render_target(checkerboard);
 
-	*texture_ref_for(Color::White, Kind::Knight) = load_texture(
-		binary_knight_white_png, binary_knight_white_png_end
-	);
+	for (uint8_t x = 0; x < 8; ++x) {
+		for (uint8_t y = 0; y < 8; ++y) {
+			const size_t idx = (x + y) % 2;
+			draw_filled_rectangle(x, y, background_colors[idx]);
+		}
+	}
 
-	*texture_ref_for(Color::White, Kind::Bishop) = load_texture(
-		binary_bishop_white_png, binary_bishop_white_png_end
-	);
+	set_render_target(nullptr);
+}
 
-	*texture_ref_for(Color::White, Kind::Pawn) = load_texture(
-		binary_pawn_white_png, binary_pawn_white_png_end
-	);
+/**
+ * Call whenever the board changed. Everything derived from the board
+ * gets computed here once instead of on every frame.
+ */
+static void board_changed()
+{
+	m_moves = chess::move_table(m_engine->board(), HUMAN);
+	m_board_changed = true;
 }
 
 void gui::begin()
 {
+	TRACE_SCOPE("gui::begin");
+
 	assert(!window);
 
 	// init sdl
@@ -242,20 +435,42 @@ void gui::begin()
 		fail_with_sdl_error();
 	}
 
-	// create the renderer
-	if (!(renderer = SDL_CreateRenderer(window, -1, 0))) {
+	// create the renderer; we draw into textures so that we
+	// only have to redraw cells that changed
+	if (!(renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_TARGETTEXTURE))) {
+		fail_with_sdl_error();
+	}
+
+	if (SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND)) {
 		fail_with_sdl_error();
 	}
 
 	// load in all assets into gpu memory
 	load_static_textures();
+	render_checkerboard();
+	canvas = create_target_texture();
+
+	// the computer reports its moves with this event
+	if ((m_engine_event = SDL_RegisterEvents(1)) == static_cast<uint32_t>(-1)) {
+		fail_with_sdl_error();
+	}
 
 	// ensure that we draw at least once
 	m_dirty = true;
 
-	// init game state
-	m_board = chess::Board::initial();
-	m_current_player = chess::Color::White;
+	// init game state; the seed comes from LUSHIN_SEED if set
+	engine::Options options;
+	options.seed = choice::local().next();
+
+	m_engine = std::make_unique<engine::Engine>(options);
+	board_changed();
+
+	// the recording has all it takes to replay the game
+	m_record_path = getenv("LUSHIN_RECORD");
+	m_record.engine = chess::swap_color(HUMAN);
+	m_record.seed = options.seed;
+	m_record.depth = ENGINE_LIMITS.depth;
+	m_record.millis = ENGINE_LIMITS.millis;
 }
 
 static void update_time()
@@ -264,88 +479,146 @@ static void update_time()
 	m_ticks = SDL_GetTicks();
 }
 
-static bool memeq(const void *buf0, const void *buf1, size_t n)
+static chess::Pos mouse_selection()
 {
-	return memcmp(buf0, buf1, n) == 0;
+	// while a button is held, motion events keep coming in even
+	// when the mouse left the window
+	const int xclamped = std::clamp(m_mouse.x, 0, 8 * CELL_DIM - 1);
+	const int yclamped = std::clamp(m_mouse.y, 0, 8 * CELL_DIM - 1);
+
+	const uint8_t xscaled = xclamped / CELL_DIM;
+	const uint8_t yscaled = yclamped / CELL_DIM;
+
+	return {xscaled, yscaled};
 }
 
-static void update_mouse_position()
+static void engine_main()
 {
-	const auto m_mouse_bk = m_mouse;
-	const uint32_t mstate = SDL_GetMouseState(&m_mouse.x, &m_mouse.y);
+	TRACE_SCOPE("engine_main");
 
-	const bool left_was_down = m_mouse.left_down;
-	const bool right_was_down = m_mouse.right_down;
+	// the game does not change while the computer thinks, so
+	// the interface can keep reading it meanwhile
+	stats::reset();
 
-	m_mouse.left_down = mstate & SDL_BUTTON(1);
-	m_mouse.right_down = mstate & SDL_BUTTON(3);
+	const uint64_t start = timer::current_micros();
+	m_engine_result = m_engine->think(ENGINE_LIMITS);
+	m_engine_micros = timer::current_micros() - start;
 
-	m_mouse.left_clicked = left_was_down && (! m_mouse.left_down);
-	m_mouse.right_clicked = right_was_down && (! m_mouse.right_down);
+	if (stats::ENABLED) {
+		stats::write_json(stderr, stats::collect());
+	}
 
-	if (!memeq(&m_mouse_bk, &m_mouse, sizeof(m_mouse))) {
-		m_dirty = true;
+	SDL_Event event = {};
+	event.type = m_engine_event;
+
+	if (SDL_PushEvent(&event) < 0) {
+		fail_with_sdl_error();
 	}
 }
 
-static chess::Pos mouse_selection()
+/**
+ * Add move to the recording of this game. micros is the time the
+ * computer took for it, 0 for moves of the human.
+ */
+static void record_move(const chess::Move &move, uint64_t micros)
 {
-	const uint8_t xscaled = m_mouse.x / CELL_DIM;
-	const uint8_t yscaled = m_mouse.y / CELL_DIM;
+	const uint32_t clamped = static_cast<uint32_t>(std::min<uint64_t>(micros, UINT32_MAX));
+	m_record.plies.push_back(record::Ply{archive::encode(move), clamped});
+}
 
-	return {xscaled, yscaled};
+/**
+ * Append this game to the recording file, if there is one and the
+ * game was not written yet.
+ */
+static void save_record()
+{
+	static bool saved;
+
+	if (!m_record_path || m_record.plies.empty() || saved) {
+		return;
+	}
+
+	record::append(m_record_path, m_record);
+	saved = true;
+}
+
+static void start_engine_move()
+{
+	assert(!m_engine_thinking);
+
+	m_engine_thinking = true;
+	m_engine_thread = std::thread(engine_main);
+}
+
+static void finish_engine_move()
+{
+	TRACE_SCOPE("finish_engine_move");
+
+	assert(m_engine_thinking);
+
+	m_engine_thread.join();
+	m_engine_thinking = false;
+	m_engine_millis.push_back(m_engine_progress.snapshot().millis);
+
+	assert(m_engine_result.move);
+	m_engine->play(*m_engine_result.move);
+	record_move(*m_engine_result.move, m_engine_micros);
+	board_changed();
+
+	// for now, report on new state here
+	if (m_moves.checked) {
+		std::cout << "check!" << std::endl;
+	}
+
+	if (m_moves.check_mated) {
+		std::cout << "checkmate!" << std::endl;
+		save_record();
+	}
 }
 
 static void update_selection()
 {
 	static chess::Pos current_selection_buf;
 
-	if (!m_mouse.left_clicked) {
+	if (!m_mouse.left_clicked || m_engine_thinking) {
 		return;
 	}
 
+	TRACE_SCOPE("update_selection");
+
 	const chess::Pos frame_mouse_selection = mouse_selection();
 
 	if (m_selected_pos) {
 		const auto &from = *m_selected_pos;
 		const auto &to = frame_mouse_selection;
 
-		const auto allowed = chess::valid_next_positions(m_board, from);
-		if (std::find(begin(allowed), end(allowed), to) != end(allowed)) {
-			std::optional<chess::Piece> thrown = m_board.move(from, to);
-			if (thrown) {
-				std::cout << "removed " << *thrown << std::endl;
+		if (m_moves.allows(from, to)) {
+			const chess::Piece thrown = m_engine->board().at(to);
+			if (thrown.present) {
+				std::cout << "removed " << thrown << std::endl;
 			}
 
-			// for now the human is always Color::White; so after a move
-			// make the cpu do a move
-			const chess::Board after_cpu = chess::best_next_board(m_board, chess::Color::Black);
-			m_board = after_cpu;
+			m_engine->play({from, to});
+			record_move({from, to}, 0);
 
-			// for now, report on new state here
-			const bool checked = chess::is_checked(m_board, m_current_player);
-			const bool check_mated = chess::is_check_mated(m_board, m_current_player);
-
-			if (checked) {
-				std::cout << "check!" << std::endl;
-			}
+			board_changed();
 
-			if (check_mated) {
-				std::cout << "checkmate!" << std::endl;
-			}
+			// for now the human is always Color::White; so after a move
+			// make the cpu do a move
+			start_engine_move();
 		}
 
 		m_selected_pos = nullptr;
 	} else {
 		assert(!m_selected_pos);
 
-		const chess::Piece &frame_piece_selection = m_board.at(frame_mouse_selection);
+		const chess::Piece &frame_piece_selection = m_engine->board().at(frame_mouse_selection);
 
 		if (!frame_piece_selection.present) {
 			return;
 		}
 
-		if (frame_piece_selection.color != m_current_player) {
+		if (frame_piece_selection.color != HUMAN) {
 			return;
 		}
 
@@ -361,147 +634,420 @@ static void update_hovered()
 
 	static chess::Pos current_hover;
 
-	if (m_selected_pos) {
-		current_hover = *m_selected_pos;
-		m_hovered_pos = &current_hover;
+	const chess::Pos hover = m_selected_pos ? *m_selected_pos : mouse_selection();
+
+	// nothing to do if neither the cell nor the board changed
+	if (m_hovered_pos && hover == current_hover && !m_board_changed) {
+		return;
+	}
+
+	current_hover = hover;
+	m_hovered_pos = &current_hover;
+	m_board_changed = false;
+
+	// if piece not present, no suggestions; empty cells have no
+	// destinations in m_moves
+
+	const chess::Piece &piece = m_engine->board().at(current_hover);
+
+	m_hovered_piece = piece.present ? &piece : nullptr;
+	m_hovered_destinations = m_moves.destinations_from(current_hover);
+}
+
+static void quit()
+{
+	// the computer might still be thinking; it stops soon after
+	// being told to, and must be done before m_engine goes away
+	if (m_engine_thread.joinable()) {
+		m_engine_cancel = true;
+		m_engine_thread.join();
+	}
+
+	save_record();
+	exit(EXIT_SUCCESS);
+}
+
+static void handle_event(const SDL_Event &event)
+{
+	switch (event.type) {
+	case SDL_QUIT:
+		quit();
+		break;
+	case SDL_MOUSEMOTION:
+		m_mouse.x = event.motion.x;
+		m_mouse.y = event.motion.y;
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP: {
+		const bool down = event.type == SDL_MOUSEBUTTONDOWN;
+
+		m_mouse.x = event.button.x;
+		m_mouse.y = event.button.y;
+
+		if (event.button.button == SDL_BUTTON_LEFT) {
+			m_mouse.left_clicked = m_mouse.left_down && !down;
+			m_mouse.left_down = down;
+		}
+
+		if (event.button.button == SDL_BUTTON_RIGHT) {
+			m_mouse.right_clicked = m_mouse.right_down && !down;
+			m_mouse.right_down = down;
+		}
+
+		break;
+	}
+	case SDL_KEYDOWN:
+		if (event.key.keysym.sym == SDLK_TAB && !event.key.repeat) {
+			m_overlay_visible = !m_overlay_visible;
+			m_overlay_changed = true;
+		}
+		break;
+	case SDL_WINDOWEVENT:
+		if (event.window.event == SDL_WINDOWEVENT_EXPOSED) {
+			m_dirty = true;
+		}
+		break;
+	case SDL_RENDER_TARGETS_RESET:
+		// contents of our textures are gone
+		render_checkerboard();
+		m_dirty = true;
+		break;
+	default:
+		if (event.type == m_engine_event) {
+			finish_engine_move();
+		}
+		break;
+	}
+}
+
+/**
+ * Return score from the point of view of the computer as text,
+ * in pawns or as the number of moves to mate.
+ */
+static std::string format_score(int score)
+{
+	char buf[32];
+
+	if (search::is_mate_score(score)) {
+		const int moves = (search::MATE - std::abs(score) + 1) / 2;
+		snprintf(buf, sizeof(buf), "%sM%d", score < 0 ? "-" : "", moves);
+	} else {
+		snprintf(buf, sizeof(buf), "%+.2f", score / 100.0);
+	}
+
+	return buf;
+}
+
+/**
+ * Return count with a unit suffix so that it stays short, like
+ * 1.23M.
+ */
+static std::string format_count(uint64_t count)
+{
+	char buf[32];
+
+	if (count >= 1000000) {
+		snprintf(buf, sizeof(buf), "%.2fM", count / 1e6);
+	} else if (count >= 1000) {
+		snprintf(buf, sizeof(buf), "%.1fk", count / 1e3);
 	} else {
-		current_hover = mouse_selection();
-		m_hovered_pos = &current_hover;
+		snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(count));
 	}
 
-	// if piece not present, no suggestions
+	return buf;
+}
 
-	const chess::Piece &piece = m_board.at(current_hover);
+/**
+ * Append line to text, cut to what fits on the overlay.
+ */
+static void append_line(std::string &text, const std::string &line)
+{
+	text.append(line, 0, OVERLAY_COLUMNS);
+	text.push_back('\n');
+}
 
-	if (!piece.present) {
-		m_hovered_piece = nullptr;
-		m_valid_next_moves_for_hovered = nullptr;
+static void update_overlay()
+{
+	if (!m_overlay_visible) {
 		return;
 	}
 
-	// if an actual piece is present, highlight suggestions
+	// the snapshot is either of the running search or of the
+	// last one, which keeps showing until the next move
+
+	const search::Snapshot snapshot = m_engine_progress.snapshot();
+	const uint64_t nps = snapshot.millis ? snapshot.nodes * 1000 / snapshot.millis : 0;
+	const int permille = m_engine->table_permille();
 
-	static std::vector<chess::Pos> next_moves;
+	std::string text;
+	char buf[64];
+
+	append_line(text, snapshot.running ? "thinking" : "waiting for you");
+
+	if (snapshot.depth > 0) {
+		snprintf(buf, sizeof(buf), "depth %d  score %s", snapshot.depth, format_score(snapshot.score).c_str());
+		append_line(text, buf);
+	} else {
+		append_line(text, "depth -");
+	}
 
-	m_hovered_piece = &piece;
-	next_moves = chess::valid_next_positions(m_board, current_hover);
-	m_valid_next_moves_for_hovered = &next_moves;
+	snprintf(buf, sizeof(buf), "nodes %s  %s/s", format_count(snapshot.nodes).c_str(), format_count(nps).c_str());
+	append_line(text, buf);
+
+	snprintf(buf, sizeof(buf), "hash %d.%d%%", permille / 10, permille % 10);
+	append_line(text, buf);
+
+	snprintf(buf, sizeof(buf), "time %.2fs", snapshot.millis / 1000.0);
+	append_line(text, buf);
+
+	if (!m_engine_millis.empty()) {
+		uint64_t total = 0;
+
+		for (const uint64_t millis : m_engine_millis) {
+			total += millis;
+		}
+
+		snprintf(
+			buf, sizeof(buf), "last %.2fs  avg %.2fs", m_engine_millis.back() / 1000.0,
+			total / 1000.0 / m_engine_millis.size()
+		);
+		append_line(text, buf);
+	}
+
+	std::string pv = "pv";
+
+	for (const chess::Move &move : snapshot.pv) {
+		pv += " " + chess::format_move(move);
+	}
+
+	append_line(text, pv);
+
+	if (text != m_overlay_text) {
+		m_overlay_text = text;
+		m_overlay_changed = true;
+	}
 }
 
 void gui::update()
 {
-	SDL_PumpEvents();
+	TRACE_SCOPE("gui::update");
 
 	update_time();
-	update_mouse_position();
-	update_selection();
+
+	SDL_Event event;
+
+	while (SDL_PollEvent(&event)) {
+		handle_event(event);
+		update_selection();
+
+		m_mouse.left_clicked = false;
+		m_mouse.right_clicked = false;
+	}
+
 	update_hovered();
+	update_overlay();
 }
 
-static void draw_background()
+static CellLook look_of(uint8_t x, uint8_t y)
 {
-	static const SDL_Color background_colors[] = {
-		SDL_WHITE, SDL_BLACK
-	};
+	const chess::Pos xy = {x, y};
+	const chess::Piece &piece = m_engine->board().at(xy);
 
-	size_t cellid = 0;
+	CellLook look = {};
 
-	for (uint8_t x = 0; x < 8; ++x) {
-		for (uint8_t y = 0; y < 8; ++y) {
-			const size_t idx = cellid++ % 2;
-			SDL_Color color = background_colors[idx];
-
-			const chess::Pos xy = {x, y};
-			bool requires_highlight = false;
-			bool requires_selection = false;
+	if (m_hovered_pos && *m_hovered_pos == xy) {
+		look.highlighted = true;
+	}
 
-			if (m_hovered_pos && *m_hovered_pos == xy) {
-				requires_highlight = true;
-			}
+	if (m_hovered_destinations & xy.bit()) {
+		look.highlighted = true;
+	}
 
-			if (m_valid_next_moves_for_hovered) {
-				const auto &moves = *m_valid_next_moves_for_hovered;
-				if (std::find(begin(moves), end(moves), xy) != end(moves)) {
-					requires_highlight =  true;
-				}
-			}
+	if (m_selected_pos && *m_selected_pos == xy && ((m_ticks / BLINK_MS) % 2)) {
+		look.selected = true;
+	}
 
-			if (m_selected_pos && *m_selected_pos == xy) {
-				requires_selection = true;
-			}
+	if (piece.present) {
+		look.occupied = true;
+		look.color = piece.color;
+		look.kind = piece.kind;
+	}
 
-			if (requires_highlight) {
-				color = blend_average(color, SDL_HIGHLIGHT);
-			}
+	return look;
+}
 
-			if (requires_selection && ((m_ticks /250) % 2)) {
-				color = blend_average(color, SDL_SELECTION);
-			}
+static bool looks_the_same(const CellLook &look0, const CellLook &look1)
+{
+	if (look0.highlighted != look1.highlighted || look0.selected != look1.selected) {
+		return false;
+	}
 
-			draw_filled_rectangle(x, y, color);
-		}
+	if (look0.occupied != look1.occupied) {
+		return false;
+	}
 
-		cellid += 1;
+	if (!look0.occupied) {
+		return true;
 	}
+
+	return look0.color == look1.color && look0.kind == look1.kind;
 }
 
-static void draw_piece_at(uint8_t x, uint8_t y)
+/**
+ * Draw the statistics of the computer in the top left corner of
+ * the render target, on a darkened background so that they stay
+ * readable over any cell.
+ */
+static void draw_overlay()
 {
-	const chess::Piece &piece = m_board.at({x, y});
+	static Batch glyphs;
+	glyphs.count = 0;
+
+	int x = OVERLAY_MARGIN;
+	int y = OVERLAY_MARGIN;
+	int width = 0;
+
+	for (char c : m_overlay_text) {
+		if (c == '\n') {
+			x = OVERLAY_MARGIN;
+			y += LINE_ADVANCE;
+			continue;
+		}
 
-	if (!piece.present) {
-		return;
-	}
+		if (c < assets::FONT_FIRST || c >= assets::FONT_FIRST + assets::FONT_GLYPHS) {
+			c = '?';
+		}
 
-	SDL_Texture *texture = texture_for(piece.color, piece.kind);
+		if (c != ' ' && glyphs.count < BATCH_PARTS) {
+			const SDL_Rect srcrect = {
+				(c - assets::FONT_FIRST) * assets::GLYPH_WIDTH, 0,
+				assets::GLYPH_WIDTH, assets::GLYPH_HEIGHT
+			};
 
-	const SDL_Rect dstrect = {
-		x * CELL_DIM, y * CELL_DIM,
-		CELL_DIM, CELL_DIM
-	};
+			const SDL_Rect dstrect = {
+				x, y,
+				assets::GLYPH_WIDTH * TEXT_SCALE, assets::GLYPH_HEIGHT * TEXT_SCALE
+			};
 
-	if (SDL_RenderCopy(renderer, texture, NULL, &dstrect)) {
-		fail_with_sdl_error();
+			batch_copy(glyphs, srcrect, assets::FONT_WIDTH, assets::FONT_HEIGHT, dstrect);
+		}
+
+		x += TEXT_ADVANCE;
+		width = std::max(width, x);
 	}
+
+	const SDL_Rect background = {
+		0, 0,
+		width + OVERLAY_MARGIN, y + OVERLAY_MARGIN
+	};
+
+	draw_blended_rectangles(&background, 1, SDL_BLACK);
+	draw_batch(glyphs, font);
 }
 
-static void draw_pieces()
+void gui::draw()
 {
+	TRACE_SCOPE("gui::draw");
+
+	assert(window);
+
+	// only touch the cells that look different from what is
+	// already on canvas; collect everything first so that
+	// each kind of drawing is a single call
+
+	static Batch backgrounds;
+	static Batch pieces;
+	SDL_Rect highlights[64];
+	SDL_Rect selections[64];
+	int nhighlights = 0;
+	int nselections = 0;
+
+	backgrounds.count = 0;
+	pieces.count = 0;
+
 	for (uint8_t x = 0; x < 8; ++x) {
 		for (uint8_t y = 0; y < 8; ++y) {
-			draw_piece_at(x, y);
+			const CellLook look = look_of(x, y);
+
+			if (!m_dirty && looks_the_same(look, m_drawn_cells[x][y])) {
+				continue;
+			}
+
+			const SDL_Rect rectangle = cell_rectangle(x, y);
+			batch_copy(backgrounds, rectangle, 8 * CELL_DIM, 8 * CELL_DIM, rectangle);
+
+			if (look.highlighted) {
+				highlights[nhighlights++] = rectangle;
+			}
+
+			if (look.selected) {
+				selections[nselections++] = rectangle;
+			}
+
+			if (look.occupied) {
+				const SDL_Rect srcrect = atlas_rectangle(look.color, look.kind);
+				batch_copy(pieces, srcrect, assets::ATLAS_WIDTH, assets::ATLAS_HEIGHT, rectangle);
+			}
+
+			m_drawn_cells[x][y] = look;
 		}
 	}
-}
 
-void gui::draw()
-{
-	if (!m_dirty) {
+	if (backgrounds.count == 0 && !m_overlay_changed) {
 		return;
 	}
 
-	assert(window);
+	// the overlay goes straight to the window and not onto
+	// canvas, so that canvas never needs to be repaired after
+	// the overlay moves or goes away
+
+	if (backgrounds.count > 0) {
+		set_render_target(canvas);
+		draw_batch(backgrounds, checkerboard);
+		draw_blended_rectangles(highlights, nhighlights, SDL_HIGHLIGHT);
+		draw_blended_rectangles(selections, nselections, SDL_SELECTION);
+		draw_batch(pieces, atlas);
+		set_render_target(nullptr);
+	}
 
 	begin_drawing();
-	draw_background();
-	draw_pieces();
+
+	if (SDL_RenderCopy(renderer, canvas, NULL, NULL)) {
+		fail_with_sdl_error();
+	}
+
+	if (m_overlay_visible) {
+		draw_overlay();
+	}
+
 	end_drawing();
 
 	m_dirty = false;
+	m_overlay_changed = false;
 }
 
-void gui::delay(int8_t fps)
+void gui::wait()
 {
-	if (fps == 0) {
-		return;
+	TRACE_SCOPE("gui::wait");
+
+	// a selected cell blinks, so wake up for the next blink,
+	// and the overlay follows the computer while it thinks;
+	// otherwise there is nothing to do until some event arrives
+
+	int timeout = -1;
+
+	if (m_selected_pos) {
+		timeout = static_cast<int>(BLINK_MS - (SDL_GetTicks() % BLINK_MS));
 	}
 
-	const int64_t ideal_delay = int64_t(1000) / static_cast<int64_t>(fps);
-	const int64_t actual_delay = ideal_delay - (static_cast<int64_t>(SDL_GetTicks()) - static_cast<int64_t>(m_ticks));
+	if (m_overlay_visible && m_engine_thinking) {
+		timeout = timeout < 0 ? OVERLAY_REFRESH_MS : std::min(timeout, OVERLAY_REFRESH_MS);
+	}
 
-	if (actual_delay > 0 && actual_delay < UINT32_MAX) {
-		const uint32_t actual_delay32 = static_cast<uint32_t>(actual_delay);
-		SDL_Delay(actual_delay32);
+	if (timeout >= 0) {
+		SDL_WaitEventTimeout(nullptr, timeout);
+	} else if (!SDL_WaitEvent(nullptr)) {
+		fail_with_sdl_error();
 	}
 }
 
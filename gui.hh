@@ -21,10 +21,11 @@ namespace gui
 	void draw();
 
 	/**
-	 * Delay execution with the aim of reaching fps. If fps is 0,
-	 * execution returns right away without any delay.
+	 * Block until there is something to update or draw, that is
+	 * until input arrives, the computer made its move or the
+	 * selected cell needs to blink.
 	 */
-	void delay(int8_t fps);
+	void wait();
 
 	/**
 	 * Return a pointer to the renderer used by the graphical user
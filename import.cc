@@ -0,0 +1,159 @@
+//
+// Import games from PGN into a game archive, see archive.hh.
+//
+// usage: lushin-import [-t THREADS] -o ARCHIVE PGN...
+//
+// Each PGN file gets mapped into memory and split into chunks at
+// game boundaries. THREADS threads (one per core by default)
+// parse the chunks, and the games get written in the order they
+// appear in the input. Games that can not be read are skipped
+// and counted.
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "archive.hh"
+#include "pgn.hh"
+
+/**
+ * Size of the pieces of text handed to each thread.
+ */
+static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+struct Totals
+{
+	size_t games;
+	size_t skipped;
+	size_t bytes;
+};
+
+static void import_file(const char *path, size_t nthreads, archive::Writer &writer, Totals &totals)
+{
+	const int fd = open(path, O_RDONLY);
+
+	if (fd == -1) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	const size_t size = static_cast<size_t>(st.st_size);
+
+	if (size == 0) {
+		close(fd);
+		return;
+	}
+
+	void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (mapped == MAP_FAILED) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	close(fd);
+	madvise(mapped, size, MADV_SEQUENTIAL);
+
+	const char *begin = static_cast<const char *>(mapped);
+	const char *end = begin + size;
+
+	std::vector<pgn::Chunk> chunks(nthreads);
+	std::vector<std::thread> threads;
+
+	// one chunk per thread at a time, so that memory use stays
+	// the same no matter how big the file is
+	for (const char *p = begin; p < end;) {
+		threads.clear();
+
+		size_t nchunks = 0;
+
+		for (; nchunks < nthreads && p < end; ++nchunks) {
+			const char *from = static_cast<size_t>(end - p) > CHUNK_SIZE ? p + CHUNK_SIZE : end;
+			const char *chunk_end = pgn::next_game(begin, end, from);
+
+			threads.emplace_back([&chunks, nchunks, p, chunk_end] {
+				chunks[nchunks] = pgn::parse(p, chunk_end);
+			});
+
+			p = chunk_end;
+		}
+
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+
+		for (size_t i = 0; i < nchunks; ++i) {
+			for (const pgn::Game &game : chunks[i].games) {
+				writer.add(game.result, game.moves.data(), game.moves.size());
+			}
+
+			totals.games += chunks[i].games.size();
+			totals.skipped += chunks[i].skipped;
+			chunks[i] = pgn::Chunk{};
+		}
+	}
+
+	totals.bytes += size;
+	munmap(mapped, size);
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr, "usage: %s [-t THREADS] -o ARCHIVE PGN...\n", argv0);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+	const char *output = nullptr;
+	std::vector<const char *> inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			nthreads = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			output = argv[++i];
+		} else if (argv[i][0] == '-') {
+			usage(argv[0]);
+		} else {
+			inputs.push_back(argv[i]);
+		}
+	}
+
+	if (!output || inputs.empty()) {
+		usage(argv[0]);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	archive::Writer writer(output);
+	Totals totals = {0, 0, 0};
+
+	for (const char *input : inputs) {
+		import_file(input, nthreads, writer, totals);
+	}
+
+	writer.finish();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	fprintf(stderr, "imported %zu games, skipped %zu, %.1f MB in %.2f s (%.1f MB/s)\n",
+	        totals.games, totals.skipped, totals.bytes / 1e6, seconds, totals.bytes / 1e6 / seconds);
+}
@@ -1,13 +1,21 @@
+#include "arena.hh"
 #include "chess.hh"
 
 using namespace chess;
 
 bool chess::is_check_mated(const Board &board, Color current_player)
 {
-	const auto next_boards = chess::valid_next_boards(board, current_player);
+	arena::Frame frame;
+	const arena::MoveList moves = frame.moves(board, current_player);
 
-	for (const Board &next_board : next_boards) {
-		if (!chess::is_checked(next_board, current_player)) {
+	Board next_board = board;
+
+	for (const Move &move : moves) {
+		frame.make(next_board, move);
+		const bool checked = chess::is_checked(next_board, current_player);
+		frame.unmake(next_board);
+
+		if (!checked) {
 			return false;
 		}
 	}
@@ -2,30 +2,106 @@
 
 using namespace chess;
 
-static bool contains_king(const Board &board, Color king_color)
+//
+// Instead of generating the moves of the opponent, look outwards
+// from the king: it is attacked if a cell from which some kind of
+// piece could take it holds an opponent piece of that kind. This
+// gives the same answer as asking the move generator whether any
+// capture takes the king, at a fraction of the cost.
+//
+
+static const Pos STRAIGHT[] = {
+	{1, 0}, {0, 1}, {-1, 0}, {0, -1}
+};
+
+static const Pos DIAGONAL[] = {
+	{1, 1}, {1, -1}, {-1, -1}, {-1, 1}
+};
+
+static const Pos KNIGHT_JUMPS[] = {
+	{1, 2}, {2, 1}, {2, -1}, {1, -2},
+	{-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+};
+
+static bool holds(const Board &board, const Pos &pos, Color color, Kind kind)
 {
-	bool contains = false;
+	if (!pos.on_board()) {
+		return false;
+	}
+
+	const Piece &piece = board.at(pos);
+	return piece.present && piece.color == color && piece.kind == kind;
+}
 
-	board.for_each([&] (const Pos &pos, const Piece &piece) {
-		(void) pos;
-		if (piece.color == king_color && piece.kind == Kind::King) {
-			contains = true;
+/**
+ * Return whether a piece of opponent that slides in one of the
+ * four directions, that is kind or a queen, can reach target.
+ */
+static bool attacked_by_slider(const Board &board, const Pos &target, Color opponent, const Pos *directions, Kind kind)
+{
+	for (size_t i = 0; i < 4; ++i) {
+		for (Pos current = target + directions[i]; current.on_board(); current += directions[i]) {
+			const Piece &piece = board.at(current);
+
+			if (!piece.present) {
+				continue;
+			}
+
+			if (piece.color == opponent && (piece.kind == kind || piece.kind == Kind::Queen)) {
+				return true;
+			}
+
+			break;
 		}
-	});
+	}
 
-	return contains;
+	return false;
 }
 
-bool chess::is_checked(const Board &board, Color current_player)
+static bool is_attacked(const Board &board, const Pos &target, Color opponent)
 {
-	const Color opponent_player = chess::swap_color(current_player);
-	const auto next_boards = chess::valid_next_boards(board, opponent_player);
+	for (const Pos &jump : KNIGHT_JUMPS) {
+		if (holds(board, target + jump, opponent, Kind::Knight)) {
+			return true;
+		}
+	}
+
+	for (const Pos *directions : {STRAIGHT, DIAGONAL}) {
+		for (size_t i = 0; i < 4; ++i) {
+			if (holds(board, target + directions[i], opponent, Kind::King)) {
+				return true;
+			}
+		}
+	}
+
+	// pawns take one row ahead; White moves towards y = 0
+	const int ahead = opponent == Color::White ? -1 : 1;
 
-	for (const Board &next_board : next_boards) {
-		if (!contains_king(next_board, current_player)) {
+	for (int side : {-1, 1}) {
+		if (holds(board, Pos(target.x + side, target.y - ahead), opponent, Kind::Pawn)) {
 			return true;
 		}
 	}
 
+	return attacked_by_slider(board, target, opponent, STRAIGHT, Kind::Rook) ||
+	       attacked_by_slider(board, target, opponent, DIAGONAL, Kind::Bishop);
+}
+
+bool chess::is_checked(const Board &board, Color current_player)
+{
+	const Color opponent = chess::swap_color(current_player);
+
+	for (uint8_t x = 0; x < 8; ++x) {
+		for (uint8_t y = 0; y < 8; ++y) {
+			const Pos pos = {x, y};
+			const Piece &piece = board.at(pos);
+
+			if (piece.present && piece.color == current_player && piece.kind == Kind::King &&
+			    is_attacked(board, pos, opponent)) {
+				return true;
+			}
+		}
+	}
+
 	return false;
 }
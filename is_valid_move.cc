@@ -0,0 +1,27 @@
+#include "chess.hh"
+
+using namespace chess;
+
+bool chess::is_valid_move(const Board &board, Color current_player, const Move &move)
+{
+	if (!move.from.on_board() || !move.to.on_board()) {
+		return false;
+	}
+
+	const Piece &piece = board.at(move.from);
+
+	if (!piece.present || piece.color != current_player) {
+		return false;
+	}
+
+	Pos tos[MAX_NEXT_POSITIONS];
+	const size_t ntos = chess::next_positions(board, move.from, tos);
+
+	for (size_t i = 0; i < ntos; ++i) {
+		if (tos[i] == move.to) {
+			return true;
+		}
+	}
+
+	return false;
+}
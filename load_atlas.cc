@@ -0,0 +1,71 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <SDL2/SDL.h>
+
+#include "assets.hh"
+#include "gui.hh"
+
+//
+// SDL helpers
+//
+
+static void fail_with_sdl_error(const char *funcname)
+{
+	const char *err = SDL_GetError();
+	fprintf(stderr, "lushin: load_atlas: %s: %s\n", funcname, err);
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_sdl_error() fail_with_sdl_error(__func__)
+
+//
+// Implementation
+//
+
+/**
+ * Return difference between start and end in bytes.
+ */
+static size_t diff_between(const uint8_t *start, const uint8_t *end)
+{
+	assert(end >= start);
+
+	ptrdiff_t diff = end - start;
+	return diff;
+}
+
+SDL_Texture *assets::load_atlas()
+{
+	// the pixels were decoded and scaled at build time; all
+	// that is left is handing them over to the gpu
+
+	const size_t pitch = ATLAS_WIDTH * ATLAS_BYTES_PER_PIXEL;
+	const size_t expected_size = pitch * ATLAS_HEIGHT;
+	const size_t actual_size = diff_between(binary_atlas_rgba, binary_atlas_rgba_end);
+
+	if (actual_size != expected_size) {
+		fprintf(stderr, "lushin: load_atlas: atlas has %zu bytes, expected %zu\n", actual_size, expected_size);
+		exit(EXIT_FAILURE);
+	}
+
+	SDL_Texture *texture = SDL_CreateTexture(
+		gui::get_renderer(), SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+		ATLAS_WIDTH, ATLAS_HEIGHT
+	);
+
+	if (!texture) {
+		fail_with_sdl_error();
+	}
+
+	if (SDL_UpdateTexture(texture, nullptr, binary_atlas_rgba, static_cast<int>(pitch))) {
+		fail_with_sdl_error();
+	}
+
+	if (SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND)) {
+		fail_with_sdl_error();
+	}
+
+	return texture;
+}
@@ -0,0 +1,122 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "assets.hh"
+#include "gui.hh"
+
+//
+// SDL helpers
+//
+
+static void fail_with_sdl_error(const char *funcname)
+{
+	const char *err = SDL_GetError();
+	fprintf(stderr, "lushin: load_font: %s: %s\n", funcname, err);
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_sdl_error() fail_with_sdl_error(__func__)
+
+//
+// Implementation
+//
+
+/**
+ * The printable ASCII characters in a 5 x 7 pixel font. Each
+ * glyph is given as its columns from left to right; bit n of a
+ * column is the pixel in row n, counted from the top.
+ */
+static const uint8_t GLYPHS[assets::FONT_GLYPHS][assets::GLYPH_WIDTH] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5f, 0x00, 0x00}, // ' ' '!'
+	{0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7f, 0x14, 0x7f, 0x14}, // '"' '#'
+	{0x24, 0x2a, 0x7f, 0x2a, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, // '$' '%'
+	{0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, // '&' '''
+	{0x00, 0x1c, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1c, 0x00}, // '(' ')'
+	{0x08, 0x2a, 0x1c, 0x2a, 0x08}, {0x08, 0x08, 0x3e, 0x08, 0x08}, // '*' '+'
+	{0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, // ',' '-'
+	{0x00, 0x60, 0x60, 0x00, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02}, // '.' '/'
+	{0x3e, 0x51, 0x49, 0x45, 0x3e}, {0x00, 0x42, 0x7f, 0x40, 0x00}, // '0' '1'
+	{0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4b, 0x31}, // '2' '3'
+	{0x18, 0x14, 0x12, 0x7f, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39}, // '4' '5'
+	{0x3c, 0x4a, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03}, // '6' '7'
+	{0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1e}, // '8' '9'
+	{0x00, 0x36, 0x36, 0x00, 0x00}, {0x00, 0x56, 0x36, 0x00, 0x00}, // ':' ';'
+	{0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14}, // '<' '='
+	{0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, // '>' '?'
+	{0x32, 0x49, 0x79, 0x41, 0x3e}, {0x7e, 0x11, 0x11, 0x11, 0x7e}, // '@' 'A'
+	{0x7f, 0x49, 0x49, 0x49, 0x36}, {0x3e, 0x41, 0x41, 0x41, 0x22}, // 'B' 'C'
+	{0x7f, 0x41, 0x41, 0x22, 0x1c}, {0x7f, 0x49, 0x49, 0x49, 0x41}, // 'D' 'E'
+	{0x7f, 0x09, 0x09, 0x01, 0x01}, {0x3e, 0x41, 0x41, 0x51, 0x32}, // 'F' 'G'
+	{0x7f, 0x08, 0x08, 0x08, 0x7f}, {0x00, 0x41, 0x7f, 0x41, 0x00}, // 'H' 'I'
+	{0x20, 0x40, 0x41, 0x3f, 0x01}, {0x7f, 0x08, 0x14, 0x22, 0x41}, // 'J' 'K'
+	{0x7f, 0x40, 0x40, 0x40, 0x40}, {0x7f, 0x02, 0x04, 0x02, 0x7f}, // 'L' 'M'
+	{0x7f, 0x04, 0x08, 0x10, 0x7f}, {0x3e, 0x41, 0x41, 0x41, 0x3e}, // 'N' 'O'
+	{0x7f, 0x09, 0x09, 0x09, 0x06}, {0x3e, 0x41, 0x51, 0x21, 0x5e}, // 'P' 'Q'
+	{0x7f, 0x09, 0x19, 0x29, 0x46}, {0x46, 0x49, 0x49, 0x49, 0x31}, // 'R' 'S'
+	{0x01, 0x01, 0x7f, 0x01, 0x01}, {0x3f, 0x40, 0x40, 0x40, 0x3f}, // 'T' 'U'
+	{0x1f, 0x20, 0x40, 0x20, 0x1f}, {0x7f, 0x20, 0x18, 0x20, 0x7f}, // 'V' 'W'
+	{0x63, 0x14, 0x08, 0x14, 0x63}, {0x03, 0x04, 0x78, 0x04, 0x03}, // 'X' 'Y'
+	{0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7f, 0x41, 0x41, 0x00}, // 'Z' '['
+	{0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7f, 0x00}, // '\' ']'
+	{0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40}, // '^' '_'
+	{0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78}, // '`' 'a'
+	{0x7f, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, // 'b' 'c'
+	{0x38, 0x44, 0x44, 0x48, 0x7f}, {0x38, 0x54, 0x54, 0x54, 0x18}, // 'd' 'e'
+	{0x08, 0x7e, 0x09, 0x01, 0x02}, {0x0c, 0x52, 0x52, 0x52, 0x3e}, // 'f' 'g'
+	{0x7f, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7d, 0x40, 0x00}, // 'h' 'i'
+	{0x20, 0x40, 0x44, 0x3d, 0x00}, {0x7f, 0x10, 0x28, 0x44, 0x00}, // 'j' 'k'
+	{0x00, 0x41, 0x7f, 0x40, 0x00}, {0x7c, 0x04, 0x18, 0x04, 0x78}, // 'l' 'm'
+	{0x7c, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, // 'n' 'o'
+	{0x7c, 0x14, 0x14, 0x14, 0x08}, {0x08, 0x14, 0x14, 0x18, 0x7c}, // 'p' 'q'
+	{0x7c, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20}, // 'r' 's'
+	{0x04, 0x3f, 0x44, 0x40, 0x20}, {0x3c, 0x40, 0x40, 0x20, 0x7c}, // 't' 'u'
+	{0x1c, 0x20, 0x40, 0x20, 0x1c}, {0x3c, 0x40, 0x30, 0x40, 0x3c}, // 'v' 'w'
+	{0x44, 0x28, 0x10, 0x28, 0x44}, {0x0c, 0x50, 0x50, 0x50, 0x3c}, // 'x' 'y'
+	{0x44, 0x64, 0x54, 0x4c, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, // 'z' '{'
+	{0x00, 0x00, 0x7f, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00}, // '|' '}'
+	{0x08, 0x04, 0x08, 0x10, 0x08},                                 // '~'
+};
+
+SDL_Texture *assets::load_font()
+{
+	// expand the bits into white pixels that are either opaque
+	// or transparent, all glyphs side by side in one row; the
+	// text color comes from the vertices when drawing
+
+	std::vector<uint8_t> pixels(FONT_WIDTH * FONT_HEIGHT * 4, 0);
+
+	for (int glyph = 0; glyph < FONT_GLYPHS; ++glyph) {
+		for (int column = 0; column < GLYPH_WIDTH; ++column) {
+			for (int row = 0; row < GLYPH_HEIGHT; ++row) {
+				if (!(GLYPHS[glyph][column] & (1 << row))) {
+					continue;
+				}
+
+				uint8_t *pixel = &pixels[(row * FONT_WIDTH + glyph * GLYPH_WIDTH + column) * 4];
+				pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0xff;
+			}
+		}
+	}
+
+	SDL_Texture *texture = SDL_CreateTexture(
+		gui::get_renderer(), SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+		FONT_WIDTH, FONT_HEIGHT
+	);
+
+	if (!texture) {
+		fail_with_sdl_error();
+	}
+
+	if (SDL_UpdateTexture(texture, nullptr, pixels.data(), FONT_WIDTH * 4)) {
+		fail_with_sdl_error();
+	}
+
+	if (SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND)) {
+		fail_with_sdl_error();
+	}
+
+	return texture;
+}
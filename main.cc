@@ -9,8 +9,8 @@ int main()
 	gui::begin();
 
 	while (true) {
+		gui::wait();
 		gui::update();
 		gui::draw();
-		gui::delay(60);
 	}
 }
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cassert>
+
+#include "arena.hh"
+#include "mate.hh"
+#include "timer.hh"
+
+using namespace chess;
+using namespace mate;
+
+//
+// The search works with phi and delta instead of proof and
+// disproof numbers: phi is the proof number of the player to move
+// winning (for the attacker: mating, for the defender: getting
+// away), delta the disproof number. That way attacker and defender
+// positions are handled by the same code, like negamax does for
+// alpha-beta.
+//
+
+/**
+ * Proof or disproof number of a position that has been settled.
+ */
+static constexpr uint32_t INFINITE = 1u << 30;
+
+/**
+ * How often (in nodes) to look at the clock.
+ */
+static constexpr uint64_t NODES_BETWEEN_CLOCK_CHECKS = 1024;
+
+/**
+ * Return the table key for current_player to move on board with
+ * plies_left plies to go. The same board with more or fewer plies
+ * left is a different question, so it gets a different key.
+ */
+static uint64_t key_for(const Board &board, Color current_player, int plies_left)
+{
+	return board.hash() ^ chess::zobrist_key(current_player) ^
+	       static_cast<uint64_t>(plies_left) * 0x9e3779b97f4a7c15ULL;
+}
+
+static uint32_t saturating_add(uint32_t a, uint32_t b)
+{
+	return std::min(a + b, INFINITE);
+}
+
+/**
+ * Return the size of a table of about megabytes.
+ */
+static size_t table_size(size_t megabytes, size_t entry_size)
+{
+	const size_t n = megabytes * 1024 * 1024 / entry_size;
+	size_t power = 1;
+
+	while (power * 2 <= n) {
+		power *= 2;
+	}
+
+	return power;
+}
+
+Solver::Solver(size_t megabytes)
+	: m_entries(table_size(megabytes, sizeof(Entry))), m_nodes(0), m_max_nodes(0), m_deadline(0), m_stopped(false)
+{
+	this->clear();
+}
+
+void Solver::clear()
+{
+	std::fill(this->m_entries.begin(), this->m_entries.end(), Entry{0, 1, 1});
+}
+
+Result Solver::solve(const Board &board, Color attacker, const Limits &limits)
+{
+	assert(limits.moves > 0);
+
+	this->m_nodes = 0;
+	this->m_max_nodes = limits.nodes;
+	this->m_deadline = limits.millis ? timer::current_millis() + limits.millis : 0;
+	this->m_stopped = false;
+
+	// every level of the search takes one arena frame
+	const int moves = std::min(limits.moves, static_cast<int>(arena::MAX_PLY - 2) / 2);
+	const int plies_left = 2 * moves - 1;
+
+	Board root = board;
+	this->expand(root, attacker, plies_left, INFINITE, INFINITE);
+
+	const Entry entry = this->lookup(key_for(root, attacker, plies_left));
+	Result result = {Outcome::Unknown, std::nullopt, this->m_nodes};
+
+	if (entry.phi == 0) {
+		result.outcome = Outcome::Mate;
+	} else if (entry.delta == 0) {
+		result.outcome = Outcome::NoMate;
+	}
+
+	if (result.outcome != Outcome::Mate) {
+		return result;
+	}
+
+	// the mating move leads to a position the defender has lost
+	arena::Frame frame;
+	const Color defender = swap_color(attacker);
+
+	for (const Move &move : frame.moves(root, attacker)) {
+		frame.make(root, move);
+		const bool lost = !chess::is_checked(root, attacker) &&
+		                  this->lookup(key_for(root, defender, plies_left - 1)).delta == 0;
+		frame.unmake(root);
+
+		if (lost) {
+			result.move = move;
+			break;
+		}
+	}
+
+	return result;
+}
+
+Solver::Entry Solver::lookup(uint64_t key) const
+{
+	const Entry &entry = this->m_entries[key & (this->m_entries.size() - 1)];
+
+	if (entry.key != key) {
+		// nothing known yet; one position to look at either way
+		return Entry{key, 1, 1};
+	}
+
+	return entry;
+}
+
+void Solver::store(uint64_t key, uint32_t phi, uint32_t delta)
+{
+	this->m_entries[key & (this->m_entries.size() - 1)] = Entry{key, phi, delta};
+}
+
+void Solver::expand(Board &board, Color current_player, int plies_left, uint32_t phi_threshold, uint32_t delta_threshold)
+{
+	const uint64_t key = key_for(board, current_player, plies_left);
+	const Color opponent = swap_color(current_player);
+
+	this->m_nodes += 1;
+
+	arena::Frame frame;
+	const arena::MoveList moves = frame.moves(board, current_player);
+
+	// keys of the positions after each legal move
+	uint64_t *children = frame.scratch<uint64_t>(moves.size());
+	size_t nchildren = 0;
+
+	for (const Move &move : moves) {
+		frame.make(board, move);
+
+		if (!chess::is_checked(board, current_player)) {
+			children[nchildren++] = key_for(board, opponent, plies_left - 1);
+		}
+
+		frame.unmake(board);
+	}
+
+	// no legal move: lost if in check, otherwise the attacker
+	// failed to mate
+	if (nchildren == 0) {
+		const bool attacking = plies_left % 2 == 1;
+
+		if (chess::is_checked(board, current_player) || attacking) {
+			this->store(key, INFINITE, 0);
+		} else {
+			this->store(key, 0, INFINITE);
+		}
+
+		return;
+	}
+
+	// the defender got away
+	if (plies_left == 0) {
+		this->store(key, 0, INFINITE);
+		return;
+	}
+
+	for (;;) {
+		// phi is the smallest delta of the children, delta the
+		// sum of their phis
+		uint32_t phi = INFINITE;
+		uint32_t delta = 0;
+		uint32_t second_phi = INFINITE;
+		uint32_t best_child_phi = 0;
+		size_t best = 0;
+
+		for (size_t i = 0; i < nchildren; ++i) {
+			const Entry child = this->lookup(children[i]);
+
+			delta = saturating_add(delta, child.phi);
+
+			if (child.delta < phi) {
+				second_phi = phi;
+				phi = child.delta;
+				best_child_phi = child.phi;
+				best = i;
+			} else if (child.delta < second_phi) {
+				second_phi = child.delta;
+			}
+		}
+
+		if (phi >= phi_threshold || delta >= delta_threshold || this->should_stop()) {
+			this->store(key, phi, delta);
+			return;
+		}
+
+		const uint32_t child_phi_threshold = saturating_add(delta_threshold - delta, best_child_phi);
+		const uint32_t child_delta_threshold = std::min(phi_threshold, saturating_add(second_phi, 1));
+
+		// find the move that leads to the best child again; the
+		// legal moves are in the same order as the children
+		size_t idx = 0;
+
+		for (const Move &move : moves) {
+			frame.make(board, move);
+
+			if (!chess::is_checked(board, current_player) && idx++ == best) {
+				this->expand(board, opponent, plies_left - 1, child_phi_threshold, child_delta_threshold);
+				frame.unmake(board);
+				break;
+			}
+
+			frame.unmake(board);
+		}
+	}
+}
+
+bool Solver::should_stop()
+{
+	if (this->m_stopped) {
+		return true;
+	}
+
+	if (this->m_max_nodes && this->m_nodes >= this->m_max_nodes) {
+		this->m_stopped = true;
+	}
+
+	if (this->m_deadline && this->m_nodes % NODES_BETWEEN_CLOCK_CHECKS == 0 &&
+	    timer::current_millis() >= this->m_deadline) {
+		this->m_stopped = true;
+	}
+
+	return this->m_stopped;
+}
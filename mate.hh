@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "chess.hh"
+
+//
+// Mate solver based on depth-first proof-number search (df-pn).
+//
+// The solver looks at the tree of moves as an AND/OR tree: the
+// attacker needs one move that mates, the defender has to be
+// mated after every move. Each position gets a proof number, the
+// least number of positions that still need to be solved to show
+// a mate, and a disproof number, the same for showing there is
+// none. The search always works on the position that looks
+// cheapest to settle, which finds deep forced mates in far fewer
+// nodes than alpha-beta.
+//
+// Mate means the usual thing here: the king is attacked and every
+// move leaves it attacked. Unlike in play, having no move without
+// being in check does not count.
+//
+
+namespace mate
+{
+	/**
+	 * What to look for and when to give up.
+	 */
+	struct Limits
+	{
+		// look for mates in at most this many moves of the
+		// attacker
+		int moves;
+
+		// maximum number of positions to expand; 0 means no
+		// limit
+		uint64_t nodes;
+
+		// maximum time in ms; 0 means no time limit
+		uint64_t millis;
+	};
+
+	enum class Outcome : uint8_t
+	{
+		// the attacker mates in at most Limits::moves moves
+		Mate = 0,
+
+		// there is no such mate
+		NoMate = 1,
+
+		// a limit was hit before the question was settled
+		Unknown = 2
+	};
+
+	struct Result
+	{
+		Outcome outcome;
+
+		// first move of the mate, if one was found
+		std::optional<chess::Move> move;
+
+		// number of positions expanded
+		uint64_t nodes;
+	};
+
+	/**
+	 * A df-pn search with its own table of proof and disproof
+	 * numbers, which is kept between calls. One Solver must only
+	 * be used by one thread at a time.
+	 */
+	class Solver
+	{
+	public:
+		/**
+		 * Create a new solver with a table of about megabytes.
+		 */
+		explicit Solver(size_t megabytes);
+
+		/**
+		 * Find out whether attacker, who is to move on board,
+		 * can force a mate within limits.
+		 */
+		Result solve(const chess::Board &board, chess::Color attacker, const Limits &limits);
+
+		/**
+		 * Forget everything stored in the table.
+		 */
+		void clear();
+
+	private:
+		struct Entry
+		{
+			uint64_t key;
+			uint32_t phi;
+			uint32_t delta;
+		};
+
+		std::vector<Entry> m_entries;
+
+		uint64_t m_nodes;
+		uint64_t m_max_nodes;
+		uint64_t m_deadline;
+		bool m_stopped;
+
+		Entry lookup(uint64_t key) const;
+		void store(uint64_t key, uint32_t phi, uint32_t delta);
+		void expand(chess::Board &board, chess::Color current_player, int plies_left, uint32_t phi_threshold,
+		            uint32_t delta_threshold);
+		bool should_stop();
+	};
+};
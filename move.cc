@@ -0,0 +1,18 @@
+#include "chess.hh"
+
+using namespace chess;
+
+bool Move::operator==(const Move &other) const
+{
+	return this->from == other.from && this->to == other.to;
+}
+
+bool Move::operator!=(const Move &other) const
+{
+	return !(*this == other);
+}
+
+std::ostream &operator<<(std::ostream &os, const chess::Move &move)
+{
+	return os << move.from << " -> " << move.to;
+}
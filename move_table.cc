@@ -0,0 +1,41 @@
+#include <cassert>
+
+#include "chess.hh"
+
+using namespace chess;
+
+uint64_t MoveTable::destinations_from(const Pos &from) const
+{
+	assert(from.on_board());
+	return this->destinations[from.x + 8 * from.y];
+}
+
+bool MoveTable::allows(const Pos &from, const Pos &to) const
+{
+	return this->destinations_from(from) & to.bit();
+}
+
+MoveTable chess::move_table(const Board &board, Color current_player)
+{
+	MoveTable table = {};
+
+	for (uint8_t x = 0; x < 8; ++x) {
+		for (uint8_t y = 0; y < 8; ++y) {
+			const Pos from = {x, y};
+
+			Pos tos[MAX_NEXT_POSITIONS];
+			const size_t ntos = chess::next_positions(board, from, tos);
+
+			uint64_t &destinations = table.destinations[x + 8 * y];
+
+			for (size_t i = 0; i < ntos; ++i) {
+				destinations |= tos[i].bit();
+			}
+		}
+	}
+
+	table.checked = chess::is_checked(board, current_player);
+	table.check_mated = chess::is_check_mated(board, current_player);
+
+	return table;
+}
@@ -0,0 +1,214 @@
+#include <cassert>
+#include <utility>
+
+#include "movepick.hh"
+
+using namespace chess;
+using namespace movepick;
+
+/**
+ * Value of pieces used for ordering captures. Taking the king
+ * ends the game and so always comes first.
+ */
+static int order_value(Kind kind)
+{
+	switch (kind) {
+	case Kind::King:
+		return 100;
+	case Kind::Queen:
+		return 9;
+	case Kind::Rook:
+		return 5;
+	case Kind::Bishop:
+		return 3;
+	case Kind::Knight:
+		return 3;
+	case Kind::Pawn:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Return the most valuable victim/least valuable attacker score
+ * of move on board. Higher means the move should be tried earlier.
+ */
+static int mvv_lva(const Board &board, const Move &move)
+{
+	const Piece &attacker = board.at(move.from);
+	const Piece &victim = board.at(move.to);
+
+	assert(victim.present);
+
+	return order_value(victim.kind) * 128 - order_value(attacker.kind);
+}
+
+Picker::Picker(arena::Frame &frame, const Board &board, Color current_player,
+               const std::optional<Move> &hash_move, const Move *killers, size_t nkillers,
+               const History &history)
+	: m_frame(frame), m_board(board), m_current_player(current_player),
+	  m_captures_only(false), m_stage(Stage::HashMove), m_hash_move(hash_move),
+	  m_nkillers(0), m_history(&history), m_moves(nullptr), m_scores(nullptr), m_nmoves(0), m_idx(0)
+{
+	assert(nkillers <= NKILLERS);
+
+	for (size_t i = 0; i < nkillers; ++i) {
+		this->m_killers[this->m_nkillers++] = killers[i];
+	}
+}
+
+Picker::Picker(arena::Frame &frame, const Board &board, Color current_player)
+	: m_frame(frame), m_board(board), m_current_player(current_player),
+	  m_captures_only(true), m_stage(Stage::GenerateCaptures), m_hash_move(std::nullopt),
+	  m_nkillers(0), m_history(nullptr), m_moves(nullptr), m_scores(nullptr), m_nmoves(0), m_idx(0)
+{
+}
+
+std::optional<Move> Picker::next()
+{
+	switch (this->m_stage) {
+	case Stage::HashMove:
+		this->m_stage = Stage::GenerateCaptures;
+
+		if (this->m_hash_move && chess::is_valid_move(this->m_board, this->m_current_player, *this->m_hash_move)) {
+			return this->m_hash_move;
+		}
+
+		// the hash move might be garbage from a hash collision
+		this->m_hash_move = std::nullopt;
+		return this->next();
+
+	case Stage::GenerateCaptures:
+		this->generate(Targets::Captures);
+		this->m_stage = Stage::Captures;
+		return this->next();
+
+	case Stage::Captures:
+		if (const auto capture = this->next_best()) {
+			return capture;
+		}
+
+		this->m_stage = this->m_captures_only ? Stage::Done : Stage::Killers;
+		this->m_idx = 0;
+		return this->next();
+
+	case Stage::Killers:
+		if (const auto killer = this->next_killer()) {
+			return killer;
+		}
+
+		this->m_stage = Stage::GenerateQuiets;
+		return this->next();
+
+	case Stage::GenerateQuiets:
+		this->generate(Targets::Quiets);
+		this->m_stage = Stage::Quiets;
+		return this->next();
+
+	case Stage::Quiets:
+		if (const auto quiet = this->next_best()) {
+			return quiet;
+		}
+
+		this->m_stage = Stage::Done;
+		return std::nullopt;
+
+	case Stage::Done:
+	default:
+		return std::nullopt;
+	}
+}
+
+bool Picker::was_tried_before(const Move &move) const
+{
+	if (this->m_hash_move && *this->m_hash_move == move) {
+		return true;
+	}
+
+	if (this->m_stage == Stage::Quiets) {
+		for (size_t i = 0; i < this->m_nkillers; ++i) {
+			if (this->m_killers[i] == move) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void Picker::generate(Targets targets)
+{
+	const arena::MoveList moves = this->m_frame.moves(this->m_board, this->m_current_player, targets);
+
+	this->m_moves = moves.begin();
+	this->m_nmoves = moves.size();
+	this->m_idx = 0;
+
+	this->m_scores = this->m_frame.scratch<int>(this->m_nmoves);
+
+	for (size_t i = 0; i < this->m_nmoves; ++i) {
+		const Move &move = this->m_moves[i];
+
+		if (targets == Targets::Captures) {
+			this->m_scores[i] = mvv_lva(this->m_board, move);
+		} else {
+			this->m_scores[i] = this->m_history->scores[move.from.x + 8 * move.from.y][move.to.x + 8 * move.to.y];
+		}
+	}
+}
+
+std::optional<Move> Picker::next_best()
+{
+	// selection sort, one step at a time; if we get cut off
+	// early, the rest never needs sorting
+
+	while (this->m_idx < this->m_nmoves) {
+		size_t best = this->m_idx;
+
+		for (size_t i = this->m_idx + 1; i < this->m_nmoves; ++i) {
+			if (this->m_scores[i] > this->m_scores[best]) {
+				best = i;
+			}
+		}
+
+		std::swap(this->m_moves[this->m_idx], this->m_moves[best]);
+		std::swap(this->m_scores[this->m_idx], this->m_scores[best]);
+
+		const Move &move = this->m_moves[this->m_idx++];
+
+		if (!this->was_tried_before(move)) {
+			return move;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::optional<Move> Picker::next_killer()
+{
+	while (this->m_idx < this->m_nkillers) {
+		const Move &killer = this->m_killers[this->m_idx++];
+
+		if (this->was_tried_before(killer)) {
+			continue;
+		}
+
+		// killers are quiet moves by definition; captures were
+		// already handed out in the previous stage
+		if (!killer.to.on_board() || this->m_board.at(killer.to).present) {
+			continue;
+		}
+
+		if (chess::is_valid_move(this->m_board, this->m_current_player, killer)) {
+			return killer;
+		}
+	}
+
+	return std::nullopt;
+}
+
+bool Picker::picking_quiets() const
+{
+	return this->m_stage == Stage::Quiets;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "arena.hh"
+#include "chess.hh"
+
+namespace movepick
+{
+	/**
+	 * Number of killer moves remembered per ply.
+	 */
+	static constexpr size_t NKILLERS = 2;
+
+	/**
+	 * Scores for quiet moves, indexed by the cells (x + 8 * y)
+	 * moved from and to. Moves that caused more cutoffs before
+	 * score higher.
+	 */
+	struct History
+	{
+		int32_t scores[64][64];
+	};
+
+	/**
+	 * Hands out the moves of one position one at a time, most
+	 * promising first. Moves are only generated once they are
+	 * asked for: first the hash move, then captures ordered by
+	 * most valuable victim/least valuable attacker, then the
+	 * killer moves and finally all other quiet moves ordered by
+	 * history. If the caller stops asking early, the later
+	 * stages never run.
+	 */
+	class Picker
+	{
+	public:
+		/**
+		 * Pick from all moves of current_player on board. Generated
+		 * moves live in frame. hash_move and killers may be moves
+		 * that are not valid on board; those get skipped. history
+		 * has to outlive the Picker.
+		 */
+		Picker(arena::Frame &frame, const chess::Board &board, chess::Color current_player,
+		       const std::optional<chess::Move> &hash_move, const chess::Move *killers, size_t nkillers,
+		       const History &history);
+
+		/**
+		 * Pick only from the captures of current_player on board.
+		 */
+		Picker(arena::Frame &frame, const chess::Board &board, chess::Color current_player);
+
+		/**
+		 * Return the next move to try or nullopt if there are
+		 * no more moves.
+		 */
+		std::optional<chess::Move> next();
+
+		/**
+		 * Return whether the last move handed out came from the
+		 * final stage, that is it is neither a capture nor the
+		 * hash move nor a killer.
+		 */
+		bool picking_quiets() const;
+
+	private:
+		enum class Stage : uint8_t
+		{
+			HashMove,
+			GenerateCaptures,
+			Captures,
+			Killers,
+			GenerateQuiets,
+			Quiets,
+			Done
+		};
+
+		arena::Frame &m_frame;
+		const chess::Board &m_board;
+		chess::Color m_current_player;
+		bool m_captures_only;
+		Stage m_stage;
+
+		std::optional<chess::Move> m_hash_move;
+		chess::Move m_killers[NKILLERS];
+		size_t m_nkillers;
+		const History *m_history;
+
+		// moves of the current stage and how far we got
+		chess::Move *m_moves;
+		int *m_scores;
+		size_t m_nmoves;
+		size_t m_idx;
+
+		bool was_tried_before(const chess::Move &move) const;
+		void generate(chess::Targets targets);
+		std::optional<chess::Move> next_best();
+		std::optional<chess::Move> next_killer();
+	};
+};
@@ -0,0 +1,38 @@
+#include <cassert>
+
+#include "chess.hh"
+#include "stats.hh"
+
+using namespace chess;
+
+size_t chess::next_moves(const Board &board, Color current_player, Move *out, Targets targets)
+{
+	stats::count(stats::Counter::MovegenCalls);
+
+	size_t nmoves = 0;
+
+	// iterate in the same order as Board::for_each, but without
+	// going through std::function which might allocate
+
+	for (uint8_t x = 0; x < 8; ++x) {
+		for (uint8_t y = 0; y < 8; ++y) {
+			const Pos from = {x, y};
+			const Piece &piece = board.at(from);
+
+			if (!piece.present || piece.color != current_player) {
+				continue;
+			}
+
+			Pos tos[MAX_NEXT_POSITIONS];
+			const size_t ntos = chess::next_positions(board, from, tos, targets);
+
+			assert(nmoves + ntos <= MAX_NEXT_MOVES);
+
+			for (size_t i = 0; i < ntos; ++i) {
+				out[nmoves++] = Move{from, tos[i]};
+			}
+		}
+	}
+
+	return nmoves;
+}
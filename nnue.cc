@@ -0,0 +1,249 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "nnue.hh"
+
+using namespace chess;
+using namespace nnue;
+
+static constexpr size_t HIDDEN = NNUE_HIDDEN;
+
+static_assert(HIDDEN % 16 == 0, "SIMD code works on 16 neurons at once");
+static_assert(HIDDEN >= 12, "built-in network needs one neuron per color and kind");
+
+static const char MAGIC[8] = {'L', 'U', 'S', 'H', 'N', 'N', 'U', 'E'};
+static constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 3 * sizeof(uint32_t);
+
+static void fail_with_message(const char *funcname, const char *path, const char *message)
+{
+	fprintf(stderr, "lushin: nnue: %s: %s: %s\n", funcname, path, message);
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_message(path, message) fail_with_message(__func__, path, message)
+
+/**
+ * Return the input for piece on pos as seen by perspective. Both
+ * sides see their own pieces as the first 6 kinds and their own
+ * back row as row 0.
+ */
+static size_t input_index(Color perspective, const Pos &pos, const Piece &piece)
+{
+	const size_t relative = piece.color == perspective ? 0 : 1;
+	const size_t kind = static_cast<size_t>(piece.kind);
+	const size_t row = perspective == Color::White ? 7 - pos.y : pos.y;
+	const size_t cell = pos.x + 8 * row;
+
+	return (relative * 6 + kind) * 64 + cell;
+}
+
+/**
+ * Return a network that only counts material: neuron n counts
+ * the pieces of kind n % 6, own ones for n < 6, the other sides
+ * ones for n < 12, and the output weighs them by piece_value.
+ */
+static Network builtin()
+{
+	static int16_t input_weights[NINPUTS * HIDDEN];
+	static int16_t input_biases[HIDDEN];
+	static int16_t output_weights[2 * HIDDEN];
+
+	for (size_t input = 0; input < NINPUTS; ++input) {
+		const size_t neuron = input / 64;
+		input_weights[input * HIDDEN + neuron] = 1;
+	}
+
+	for (size_t kind = 0; kind < 6; ++kind) {
+		const int value = chess::piece_value(static_cast<Kind>(kind));
+
+		output_weights[kind] = static_cast<int16_t>(value);
+		output_weights[6 + kind] = static_cast<int16_t>(-value);
+	}
+
+	return Network{input_weights, input_biases, output_weights, 0, 1};
+}
+
+static uint32_t read_u32(const uint8_t *bytes)
+{
+	return static_cast<uint32_t>(bytes[0]) |
+	       static_cast<uint32_t>(bytes[1]) << 8 |
+	       static_cast<uint32_t>(bytes[2]) << 16 |
+	       static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+Network nnue::load(const char *path)
+{
+	int fd;
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	const size_t nweights = NINPUTS * HIDDEN + HIDDEN + 2 * HIDDEN;
+	const size_t expected_size = HEADER_SIZE + nweights * sizeof(int16_t);
+
+	if (static_cast<size_t>(st.st_size) != expected_size) {
+		fail_with_message(path, "file size does not fit the network");
+	}
+
+	// the mapping stays around until the program exits
+	void *mapped = mmap(nullptr, expected_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (mapped == MAP_FAILED) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	close(fd);
+
+	const uint8_t *bytes = static_cast<const uint8_t *>(mapped);
+
+	if (memcmp(bytes, MAGIC, sizeof(MAGIC))) {
+		fail_with_message(path, "not a weights file");
+	}
+
+	if (read_u32(bytes + 8) != HIDDEN) {
+		fail_with_message(path, "hidden layer size does not match NNUE_HIDDEN");
+	}
+
+	Network network;
+
+	network.output_bias = static_cast<int32_t>(read_u32(bytes + 12));
+	network.output_scale = static_cast<int32_t>(read_u32(bytes + 16));
+
+	if (network.output_scale <= 0) {
+		fail_with_message(path, "output scale must be positive");
+	}
+
+	const int16_t *weights = reinterpret_cast<const int16_t *>(bytes + HEADER_SIZE);
+
+	network.input_weights = weights;
+	network.input_biases = weights + NINPUTS * HIDDEN;
+	network.output_weights = weights + NINPUTS * HIDDEN + HIDDEN;
+
+	return network;
+}
+
+const Network &nnue::network()
+{
+	static const Network network = [] {
+		const char *path = getenv("LUSHIN_NNUE");
+		return path ? nnue::load(path) : builtin();
+	}();
+
+	return network;
+}
+
+void nnue::reset(Accumulator &accumulator)
+{
+	const Network &net = network();
+
+	for (size_t perspective = 0; perspective < 2; ++perspective) {
+		memcpy(accumulator.values[perspective], net.input_biases, HIDDEN * sizeof(int16_t));
+	}
+}
+
+void nnue::add(Accumulator &accumulator, const Pos &pos, const Piece &piece)
+{
+	const Network &net = network();
+
+	for (Color perspective : {Color::Black, Color::White}) {
+		const int16_t *column = net.input_weights + input_index(perspective, pos, piece) * HIDDEN;
+		int16_t *values = accumulator.values[static_cast<size_t>(perspective)];
+
+		for (size_t i = 0; i < HIDDEN; ++i) {
+			values[i] += column[i];
+		}
+	}
+}
+
+void nnue::remove(Accumulator &accumulator, const Pos &pos, const Piece &piece)
+{
+	const Network &net = network();
+
+	for (Color perspective : {Color::Black, Color::White}) {
+		const int16_t *column = net.input_weights + input_index(perspective, pos, piece) * HIDDEN;
+		int16_t *values = accumulator.values[static_cast<size_t>(perspective)];
+
+		for (size_t i = 0; i < HIDDEN; ++i) {
+			values[i] -= column[i];
+		}
+	}
+}
+
+/**
+ * Return the sum of clamp(values[i]) * weights[i].
+ */
+static int32_t clamped_dot(const int16_t *values, const int16_t *weights)
+{
+#if defined(__AVX2__)
+	const __m256i low = _mm256_setzero_si256();
+	const __m256i high = _mm256_set1_epi16(CLAMP_MAX);
+	__m256i sum = _mm256_setzero_si256();
+
+	for (size_t i = 0; i < HIDDEN; i += 16) {
+		__m256i v = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+		const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+
+		v = _mm256_min_epi16(_mm256_max_epi16(v, low), high);
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, w));
+	}
+
+	__m128i folded = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, 0x4e));
+	folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, 0xb1));
+
+	return _mm_cvtsi128_si32(folded);
+#elif defined(__SSE2__)
+	const __m128i low = _mm_setzero_si128();
+	const __m128i high = _mm_set1_epi16(CLAMP_MAX);
+	__m128i sum = _mm_setzero_si128();
+
+	for (size_t i = 0; i < HIDDEN; i += 8) {
+		__m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i));
+		const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+
+		v = _mm_min_epi16(_mm_max_epi16(v, low), high);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(v, w));
+	}
+
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+
+	return _mm_cvtsi128_si32(sum);
+#else
+	int32_t sum = 0;
+
+	for (size_t i = 0; i < HIDDEN; ++i) {
+		const int16_t v = values[i] < 0 ? 0 : (values[i] > CLAMP_MAX ? CLAMP_MAX : values[i]);
+		sum += static_cast<int32_t>(v) * weights[i];
+	}
+
+	return sum;
+#endif
+}
+
+int nnue::evaluate(const Accumulator &accumulator, Color current_player)
+{
+	const Network &net = network();
+
+	const int16_t *own = accumulator.values[static_cast<size_t>(current_player)];
+	const int16_t *other = accumulator.values[static_cast<size_t>(swap_color(current_player))];
+
+	const int32_t sum = clamped_dot(own, net.output_weights) + clamped_dot(other, net.output_weights + HIDDEN);
+
+	return (sum + net.output_bias) / net.output_scale;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "chess.hh"
+
+//
+// Efficiently updatable neural evaluation.
+//
+// The network has one input for each combination of piece and
+// cell, seen from each side: "own rook on a1" for White is the
+// same input as "own rook on a8" for Black. Inputs feed a layer
+// of chess::NNUE_HIDDEN neurons per side, the Accumulator. As
+// only a few inputs change with each move, Board updates the
+// accumulator by adding and subtracting weight columns instead
+// of computing it from scratch. The clamped accumulators of the
+// side to move and of the other side then feed a single output
+// neuron.
+//
+// Without a weights file, a built-in network is used that counts
+// material the same way chess::piece_value does. A trained one
+// gets loaded from the file named by the LUSHIN_NNUE environment
+// variable, see load.
+//
+
+namespace nnue
+{
+	/**
+	 * Number of inputs per side: 2 colors * 6 kinds * 64 cells.
+	 */
+	static constexpr size_t NINPUTS = 2 * 6 * 64;
+
+	/**
+	 * Accumulator values get clamped to [0, CLAMP_MAX] before
+	 * going into the output neuron.
+	 */
+	static constexpr int16_t CLAMP_MAX = 127;
+
+	/**
+	 * Weights of a network. They point either into the built-in
+	 * network or into a mapped file.
+	 */
+	struct Network
+	{
+		// [NINPUTS][NNUE_HIDDEN]
+		const int16_t *input_weights;
+
+		// [NNUE_HIDDEN]
+		const int16_t *input_biases;
+
+		// [2 * NNUE_HIDDEN], side to move first
+		const int16_t *output_weights;
+
+		int32_t output_bias;
+
+		// output neuron sum gets divided by this to give
+		// centipawns
+		int32_t output_scale;
+	};
+
+	/**
+	 * Return the network in use. On first call it gets loaded
+	 * from LUSHIN_NNUE if that is set, otherwise the built-in
+	 * network is used.
+	 */
+	const Network &network();
+
+	/**
+	 * Map the weights file at path into memory and return the
+	 * network in it. Exits the program if the file can not be
+	 * read or does not fit chess::NNUE_HIDDEN.
+	 *
+	 * The file starts with the 8 bytes "LUSHNNUE", followed by
+	 * little endian uint32 hidden size, int32 output bias and
+	 * int32 output scale, then the int16 input weights, input
+	 * biases and output weights in the order of Network.
+	 */
+	Network load(const char *path);
+
+	/**
+	 * Set accumulator to what it is for an empty board.
+	 */
+	void reset(chess::Accumulator &accumulator);
+
+	/**
+	 * Update accumulator for piece getting put on pos.
+	 */
+	void add(chess::Accumulator &accumulator, const chess::Pos &pos, const chess::Piece &piece);
+
+	/**
+	 * Update accumulator for piece getting taken off pos.
+	 */
+	void remove(chess::Accumulator &accumulator, const chess::Pos &pos, const chess::Piece &piece);
+
+	/**
+	 * Return the output of the network for accumulator from the
+	 * point of view of current_player in centipawns.
+	 */
+	int evaluate(const chess::Accumulator &accumulator, chess::Color current_player);
+};
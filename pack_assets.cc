@@ -0,0 +1,143 @@
+//
+// Build time tool that decodes the PNG assets, scales them to
+// assets::PIECE_DIM and writes them out as one raw RGBA atlas.
+// The result gets linked into lushin so that the game itself
+// never has to decode any images.
+//
+// usage: pack_assets OUTPUT PNG...
+//
+// The PNGs have to be given in atlas order, that is row by row
+// (black, then white) and within each row in the order of the
+// chess::Kind enum.
+//
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include "assets.hh"
+
+static void fail_with_sdl_error(const char *funcname)
+{
+	const char *err = SDL_GetError();
+	fprintf(stderr, "lushin: pack_assets: %s: %s\n", funcname, err);
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_sdl_error() fail_with_sdl_error(__func__)
+
+static void fail_with_img_error(const char *funcname)
+{
+	const char *err = IMG_GetError();
+	fprintf(stderr, "lushin: pack_assets: sdl_image: %s: %s\n", funcname, err);
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_img_error() fail_with_img_error(__func__)
+
+/**
+ * Load the PNG at path and scale it into its cell of atlas.
+ */
+static void pack_into(SDL_Surface *atlas, const char *path, int idx)
+{
+	using namespace assets;
+
+	SDL_Surface *loaded;
+	if (!(loaded = IMG_Load(path))) {
+		fail_with_img_error();
+	}
+
+	SDL_Surface *converted;
+	if (!(converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0))) {
+		fail_with_sdl_error();
+	}
+
+	SDL_FreeSurface(loaded);
+
+	// copy alpha as it is instead of blending it onto the
+	// empty atlas
+	if (SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE)) {
+		fail_with_sdl_error();
+	}
+
+	SDL_Rect dstrect = {
+		(idx % ATLAS_COLUMNS) * PIECE_DIM, (idx / ATLAS_COLUMNS) * PIECE_DIM,
+		PIECE_DIM, PIECE_DIM
+	};
+
+	if (SDL_BlitScaled(converted, nullptr, atlas, &dstrect)) {
+		fail_with_sdl_error();
+	}
+
+	SDL_FreeSurface(converted);
+}
+
+/**
+ * Write the pixels of atlas to path, row by row without padding.
+ */
+static void write_atlas(SDL_Surface *atlas, const char *path)
+{
+	using namespace assets;
+
+	FILE *fp;
+	if (!(fp = fopen(path, "wb"))) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	if (SDL_LockSurface(atlas)) {
+		fail_with_sdl_error();
+	}
+
+	const size_t row_size = ATLAS_WIDTH * ATLAS_BYTES_PER_PIXEL;
+
+	for (int y = 0; y < ATLAS_HEIGHT; ++y) {
+		const uint8_t *row = static_cast<const uint8_t *>(atlas->pixels) + y * atlas->pitch;
+
+		if (fwrite(row, 1, row_size, fp) != row_size) {
+			perror(path);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	SDL_UnlockSurface(atlas);
+
+	if (fclose(fp)) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	using namespace assets;
+
+	const int npieces = ATLAS_COLUMNS * ATLAS_ROWS;
+
+	if (argc != npieces + 2) {
+		fprintf(stderr, "usage: %s OUTPUT PNG...\n", argv[0]);
+		fprintf(stderr, "exactly %d PNGs are required\n", npieces);
+		exit(EXIT_FAILURE);
+	}
+
+	if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+		fail_with_img_error();
+	}
+
+	SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(
+		0, ATLAS_WIDTH, ATLAS_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32
+	);
+
+	if (!atlas) {
+		fail_with_sdl_error();
+	}
+
+	for (int i = 0; i < npieces; ++i) {
+		pack_into(atlas, argv[i + 2], i);
+	}
+
+	write_atlas(atlas, argv[1]);
+	SDL_FreeSurface(atlas);
+}
@@ -0,0 +1,182 @@
+#include "pawns.hh"
+#include "stats.hh"
+#include "weights.hh"
+
+using namespace chess;
+using namespace pawns;
+
+static constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+
+static uint64_t file_mask(int x)
+{
+	if (x < 0 || x > 7) {
+		return 0;
+	}
+
+	return FILE_A << x;
+}
+
+static uint64_t row_mask(int y)
+{
+	if (y < 0 || y > 7) {
+		return 0;
+	}
+
+	return 0xffULL << (8 * y);
+}
+
+/**
+ * Return all cells in front of row y from the point of view of
+ * color. White moves up (towards y = 0), Black moves down.
+ */
+static uint64_t rows_ahead(Color color, int y)
+{
+	uint64_t mask = 0;
+
+	if (color == Color::White) {
+		for (int row = 0; row < y; ++row) {
+			mask |= row_mask(row);
+		}
+	} else {
+		for (int row = y + 1; row < 8; ++row) {
+			mask |= row_mask(row);
+		}
+	}
+
+	return mask;
+}
+
+static int popcount(uint64_t mask)
+{
+	return __builtin_popcountll(mask);
+}
+
+Terms pawns::count_terms(const uint64_t *pawns, Color color)
+{
+	const uint64_t own = pawns[static_cast<size_t>(color)];
+	const uint64_t theirs = pawns[static_cast<size_t>(swap_color(color))];
+
+	Terms terms = {};
+
+	for (int x = 0; x < 8; ++x) {
+		const int on_file = popcount(own & file_mask(x));
+
+		if (on_file == 0) {
+			continue;
+		}
+
+		terms.doubled += on_file - 1;
+
+		const uint64_t adjacent = file_mask(x - 1) | file_mask(x + 1);
+
+		if (!(own & adjacent)) {
+			terms.isolated += on_file;
+		}
+
+		for (int y = 0; y < 8; ++y) {
+			if (!(own & Pos(x, y).bit())) {
+				continue;
+			}
+
+			const uint64_t blockers = (file_mask(x) | adjacent) & rows_ahead(color, y);
+
+			if (!(theirs & blockers)) {
+				const int advanced = color == Color::White ? 6 - y : y - 1;
+
+				if (advanced >= 0 && advanced < NPASSED) {
+					terms.passed[advanced] += 1;
+				}
+			}
+		}
+	}
+
+	return terms;
+}
+
+/**
+ * Return the score of the pawns of color, not counting shields.
+ */
+static int evaluate_color(const uint64_t *pawns, Color color)
+{
+	const Terms terms = pawns::count_terms(pawns, color);
+
+	int score = -terms.doubled * weights::DOUBLED_PENALTY - terms.isolated * weights::ISOLATED_PENALTY;
+
+	for (int i = 0; i < NPASSED; ++i) {
+		score += terms.passed[i] * weights::PASSED_BONUS[i];
+	}
+
+	return score;
+}
+
+Entry pawns::evaluate(const Board &board)
+{
+	Entry entry = {board.pawn_hash(), {0, 0}, 0};
+
+	for (uint8_t x = 0; x < 8; ++x) {
+		for (uint8_t y = 0; y < 8; ++y) {
+			const Pos pos = {x, y};
+			const Piece &piece = board.at(pos);
+
+			if (piece.present && piece.kind == Kind::Pawn) {
+				entry.pawns[static_cast<size_t>(piece.color)] |= pos.bit();
+			}
+		}
+	}
+
+	entry.score = evaluate_color(entry.pawns, Color::White) - evaluate_color(entry.pawns, Color::Black);
+	return entry;
+}
+
+Shield pawns::count_shield(const Entry &entry, Color color, const Pos &king_pos)
+{
+	// only a king that stayed back has anything to shield
+	const bool at_home = color == Color::White ? king_pos.y >= 6 : king_pos.y <= 1;
+
+	if (!at_home) {
+		return Shield{0, 0};
+	}
+
+	const int forward = color == Color::White ? -1 : 1;
+	const uint64_t files = file_mask(king_pos.x - 1) | file_mask(king_pos.x) | file_mask(king_pos.x + 1);
+	const uint64_t own = entry.pawns[static_cast<size_t>(color)];
+
+	const uint64_t near = own & files & row_mask(king_pos.y + forward);
+	const uint64_t far = own & files & row_mask(king_pos.y + 2 * forward);
+
+	return Shield{popcount(near), popcount(far)};
+}
+
+int pawns::shield(const Entry &entry, Color color, const Pos &king_pos)
+{
+	const Shield shield = pawns::count_shield(entry, color, king_pos);
+	return shield.near * weights::SHIELD_NEAR_BONUS + shield.far * weights::SHIELD_FAR_BONUS;
+}
+
+Table::Table() : m_entries(TABLE_SIZE)
+{
+	// an all zero entry is right for the board without pawns,
+	// so empty slots need no marker
+}
+
+const Entry &Table::probe(const Board &board)
+{
+	const uint64_t key = board.pawn_hash();
+	Entry &entry = this->m_entries[key & (TABLE_SIZE - 1)];
+
+	stats::count(stats::Counter::PawnProbes);
+
+	if (entry.key == key) {
+		stats::count(stats::Counter::PawnHits);
+	} else {
+		entry = pawns::evaluate(board);
+	}
+
+	return entry;
+}
+
+Table &pawns::local()
+{
+	static thread_local Table table;
+	return table;
+}
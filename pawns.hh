@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "chess.hh"
+
+namespace pawns
+{
+	/**
+	 * Number of entries in the pawn table of each thread.
+	 */
+	static constexpr size_t TABLE_SIZE = 1 << 13;
+
+	/**
+	 * What we know about the pawns of one board. Depends on the
+	 * pawns only, so it can be shared between all boards with
+	 * the same pawn hash.
+	 */
+	struct Entry
+	{
+		// Board::pawn_hash of the board
+		uint64_t key;
+
+		// cells (bit x + 8 * y) with pawns, indexed by color
+		uint64_t pawns[2];
+
+		// doubled, isolated and passed pawns in centipawns
+		// from the point of view of White
+		int32_t score;
+	};
+
+	/**
+	 * Number of rows a passed pawn can have advanced, see
+	 * weights::PASSED_BONUS.
+	 */
+	static constexpr int NPASSED = 7;
+
+	/**
+	 * How often each pawn structure term applies to one color.
+	 */
+	struct Terms
+	{
+		int doubled;
+		int isolated;
+
+		// indexed by how many rows the passed pawn advanced
+		int passed[NPASSED];
+	};
+
+	/**
+	 * Number of pawns right in front of a king (near) and one
+	 * row further (far).
+	 */
+	struct Shield
+	{
+		int near;
+		int far;
+	};
+
+	/**
+	 * Count the terms for the pawns of color, given the pawn
+	 * masks of both colors as in Entry.
+	 */
+	Terms count_terms(const uint64_t *pawns, chess::Color color);
+
+	/**
+	 * Count the pawns of color shielding its king on king_pos.
+	 */
+	Shield count_shield(const Entry &entry, chess::Color color, const chess::Pos &king_pos);
+
+	/**
+	 * Score the pawn structure of board without looking at any
+	 * table.
+	 */
+	Entry evaluate(const chess::Board &board);
+
+	/**
+	 * Return the bonus in centipawns for the pawns of color
+	 * standing right in front of its king on king_pos.
+	 */
+	int shield(const Entry &entry, chess::Color color, const chess::Pos &king_pos);
+
+	/**
+	 * A fixed size cache of evaluated pawn structures. Each key
+	 * maps to exactly one slot; newer entries replace older
+	 * ones. Pawns rarely move, so nearly every lookup hits.
+	 */
+	class Table
+	{
+	public:
+		Table();
+
+		/**
+		 * Return the entry for the pawns of board, evaluating
+		 * them if they are not in the table yet. The reference
+		 * stays valid until the next call.
+		 */
+		const Entry &probe(const chess::Board &board);
+
+	private:
+		std::vector<Entry> m_entries;
+	};
+
+	/**
+	 * Return the table of the calling thread.
+	 */
+	Table &local();
+};
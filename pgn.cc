@@ -0,0 +1,506 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "pgn.hh"
+
+using namespace chess;
+using namespace pgn;
+
+static Kind kind_for(char c)
+{
+	switch (c) {
+	case 'K':
+		return Kind::King;
+	case 'Q':
+		return Kind::Queen;
+	case 'R':
+		return Kind::Rook;
+	case 'B':
+		return Kind::Bishop;
+	case 'N':
+		return Kind::Knight;
+	default:
+		throw std::invalid_argument(std::string("bad piece in move: ") + c);
+	}
+}
+
+static bool is_own(const Board &board, const Pos &pos, Color color, Kind kind)
+{
+	const Piece &piece = board.at(pos);
+	return piece.present && piece.color == color && piece.kind == kind;
+}
+
+/**
+ * Return whether doing move leaves the king of current_player where
+ * the opponent can take it.
+ */
+static bool leaves_king_open(const Board &board, Color current_player, archive::Move move)
+{
+	Board next = board;
+	archive::apply(next, move);
+
+	return chess::is_checked(next, current_player);
+}
+
+static archive::Move castle(const Board &board, Color current_player, bool short_side, const std::string &san)
+{
+	const int y = current_player == Color::White ? 7 : 0;
+	const Pos king(4, y);
+	const Pos rook(short_side ? 7 : 0, y);
+	const Pos passing(short_side ? 5 : 3, y);
+
+	if (!is_own(board, king, current_player, Kind::King) || !is_own(board, rook, current_player, Kind::Rook)) {
+		throw std::invalid_argument("castling not possible: " + san);
+	}
+
+	for (int x = std::min(king.x, rook.x) + 1; x < std::max(king.x, rook.x); ++x) {
+		if (board.at(Pos(x, y)).present) {
+			throw std::invalid_argument("castling not possible: " + san);
+		}
+	}
+
+	// the king may not castle out of or through check either
+	Board through = board;
+	through.move(king, passing);
+
+	if (chess::is_checked(board, current_player) || chess::is_checked(through, current_player)) {
+		throw std::invalid_argument("castling not possible: " + san);
+	}
+
+	const archive::Move move = archive::encode(Move{king, Pos(short_side ? 6 : 2, y)}, archive::Special::Castling);
+
+	if (leaves_king_open(board, current_player, move)) {
+		throw std::invalid_argument("castling not possible: " + san);
+	}
+
+	return move;
+}
+
+static archive::Move en_passant(const Board &board, Color current_player, int from_x, const Pos &to, const std::string &san)
+{
+	// White moves up, towards y = 0
+	const int forward = current_player == Color::White ? -1 : 1;
+	const int target_row = current_player == Color::White ? 2 : 5;
+
+	if (from_x < 0 || to.y != target_row || std::abs(from_x - to.x) != 1) {
+		throw std::invalid_argument("illegal move: " + san);
+	}
+
+	const Pos from(from_x, to.y - forward);
+	const Pos taken(static_cast<int>(to.x), static_cast<int>(from.y));
+
+	if (!is_own(board, from, current_player, Kind::Pawn) || !is_own(board, taken, swap_color(current_player), Kind::Pawn)) {
+		throw std::invalid_argument("illegal move: " + san);
+	}
+
+	const archive::Move move = archive::encode(Move{from, to}, archive::Special::EnPassant);
+
+	if (leaves_king_open(board, current_player, move)) {
+		throw std::invalid_argument("illegal move: " + san);
+	}
+
+	return move;
+}
+
+archive::Move pgn::parse_san(const Board &board, Color current_player, const std::string &text)
+{
+	std::string san = text;
+
+	// check, mate and annotation marks say nothing about the move
+	while (!san.empty() && strchr("+#!?", san.back())) {
+		san.pop_back();
+	}
+
+	if (san == "O-O" || san == "0-0") {
+		return castle(board, current_player, true, text);
+	}
+
+	if (san == "O-O-O" || san == "0-0-0") {
+		return castle(board, current_player, false, text);
+	}
+
+	Kind kind = Kind::Pawn;
+	size_t begin = 0;
+
+	if (!san.empty() && isupper(static_cast<unsigned char>(san[0]))) {
+		kind = kind_for(san[0]);
+		begin = 1;
+	}
+
+	std::optional<Kind> promotion;
+
+	if (kind == Kind::Pawn && san.size() > 2 && isupper(static_cast<unsigned char>(san.back()))) {
+		promotion = kind_for(san.back());
+		san.pop_back();
+
+		if (san.back() == '=') {
+			san.pop_back();
+		}
+
+		if (*promotion == Kind::King) {
+			throw std::invalid_argument("bad promotion: " + text);
+		}
+	}
+
+	if (san.size() < begin + 2) {
+		throw std::invalid_argument("bad move: " + text);
+	}
+
+	const char file = san[san.size() - 2];
+	const char rank = san[san.size() - 1];
+
+	if (file < 'a' || file > 'h' || rank < '1' || rank > '8') {
+		throw std::invalid_argument("bad move: " + text);
+	}
+
+	// ranks count from White's side, y from Black's
+	const Pos to(file - 'a', '8' - rank);
+
+	// between piece and target: where the piece comes from, if
+	// that is needed to tell moves apart, and the capture mark
+	int from_x = -1;
+	int from_y = -1;
+	bool capture = false;
+
+	for (size_t i = begin; i < san.size() - 2; ++i) {
+		const char c = san[i];
+
+		if (c == 'x') {
+			capture = true;
+		} else if (c >= 'a' && c <= 'h') {
+			from_x = c - 'a';
+		} else if (c >= '1' && c <= '8') {
+			from_y = '8' - c;
+		} else {
+			throw std::invalid_argument("bad move: " + text);
+		}
+	}
+
+	if (kind == Kind::Pawn && capture && !board.at(to).present) {
+		return en_passant(board, current_player, from_x, to, text);
+	}
+
+	Move candidates[16];
+	size_t ncandidates = 0;
+
+	for (int x = 0; x < 8; ++x) {
+		for (int y = 0; y < 8; ++y) {
+			const Pos from(x, y);
+
+			if ((from_x >= 0 && x != from_x) || (from_y >= 0 && y != from_y)) {
+				continue;
+			}
+
+			if (!is_own(board, from, current_player, kind)) {
+				continue;
+			}
+
+			// pawns change columns exactly when they take
+			if (kind == Kind::Pawn && (x != to.x) != capture) {
+				continue;
+			}
+
+			const Move move = {from, to};
+
+			if (chess::is_valid_move(board, current_player, move)) {
+				candidates[ncandidates++] = move;
+			}
+		}
+	}
+
+	// SAN only names the from cell as far as needed to tell apart
+	// the moves that are legal, so pinned pieces have to be ruled
+	// out; looking for those is only worth it if there is a choice
+	std::optional<Move> found;
+
+	if (ncandidates == 1) {
+		found = candidates[0];
+	}
+
+	for (size_t i = 0; i < ncandidates && ncandidates > 1; ++i) {
+		if (leaves_king_open(board, current_player, archive::encode(candidates[i]))) {
+			continue;
+		}
+
+		if (found) {
+			throw std::invalid_argument("ambiguous move: " + text);
+		}
+
+		found = candidates[i];
+	}
+
+	if (!found) {
+		throw std::invalid_argument("illegal move: " + text);
+	}
+
+	const bool promotes = kind == Kind::Pawn && (to.y == 0 || to.y == 7);
+
+	if (promotes != promotion.has_value()) {
+		throw std::invalid_argument("bad promotion: " + text);
+	}
+
+	if (promotes) {
+		return archive::encode(*found, archive::Special::Promotion, *promotion);
+	}
+
+	return archive::encode(*found);
+}
+
+/**
+ * A game while it is being read.
+ */
+struct Reading
+{
+	Board board;
+	Color current_player;
+	Game game;
+
+	// whether any tag or move of the game was seen yet
+	bool started;
+
+	// whether the moves of the game began
+	bool in_moves;
+
+	// whether the game gets left out
+	bool skip;
+
+	// whether the text is inside a {} comment, and how many
+	// () variations deep
+	bool in_comment;
+	int variation_depth;
+};
+
+static void start_game(Reading &reading)
+{
+	reading.board = Board::initial();
+	reading.current_player = Color::White;
+	reading.game = Game{archive::Result::Unknown, {}};
+	reading.started = true;
+	reading.in_moves = false;
+	reading.skip = false;
+	reading.in_comment = false;
+	reading.variation_depth = 0;
+}
+
+static void finish_game(Reading &reading, Chunk &chunk)
+{
+	if (!reading.started) {
+		return;
+	}
+
+	if (reading.skip || reading.game.moves.size() > archive::MAX_MOVES) {
+		chunk.skipped += 1;
+	} else {
+		chunk.games.push_back(std::move(reading.game));
+	}
+
+	reading.started = false;
+}
+
+static bool parse_result(const std::string &text, archive::Result &result)
+{
+	if (text == "1-0") {
+		result = archive::Result::WhiteWins;
+	} else if (text == "0-1") {
+		result = archive::Result::BlackWins;
+	} else if (text == "1/2-1/2") {
+		result = archive::Result::Draw;
+	} else if (text == "*") {
+		result = archive::Result::Unknown;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+static void read_tag(Reading &reading, const std::string &line)
+{
+	const size_t name_end = line.find_first_of(" \t\"]", 1);
+	const size_t value_begin = line.find('"');
+	const size_t value_end = line.rfind('"');
+
+	if (name_end == std::string::npos || value_begin == std::string::npos || value_begin == value_end) {
+		return;
+	}
+
+	const std::string name = line.substr(1, name_end - 1);
+	const std::string value = line.substr(value_begin + 1, value_end - value_begin - 1);
+
+	if (name == "Result") {
+		parse_result(value, reading.game.result);
+	} else if (name == "FEN" || (name == "Variant" && value != "Standard")) {
+		// the archive only holds games from the initial board
+		reading.skip = true;
+	}
+}
+
+static void read_token(Reading &reading, Chunk &chunk, std::string token)
+{
+	if (parse_result(token, reading.game.result)) {
+		finish_game(reading, chunk);
+		return;
+	}
+
+	// annotation glyphs like $1
+	if (token[0] == '$') {
+		return;
+	}
+
+	// move numbers like 12. or 12... may stick to the move
+	size_t digits = 0;
+
+	while (digits < token.size() && isdigit(static_cast<unsigned char>(token[digits]))) {
+		++digits;
+	}
+
+	if (digits > 0 && digits < token.size() && token[digits] == '.') {
+		token.erase(0, token.find_first_not_of('.', digits));
+	} else if (digits == token.size()) {
+		return;
+	}
+
+	if (token.empty() || token.find_first_not_of('.') == std::string::npos || reading.skip) {
+		return;
+	}
+
+	try {
+		const archive::Move move = pgn::parse_san(reading.board, reading.current_player, token);
+
+		archive::apply(reading.board, move);
+		reading.game.moves.push_back(move);
+		reading.current_player = swap_color(reading.current_player);
+	} catch (const std::invalid_argument &) {
+		reading.skip = true;
+	}
+}
+
+static void read_moves(Reading &reading, Chunk &chunk, const std::string &line)
+{
+	size_t i = 0;
+
+	while (i < line.size()) {
+		const char c = line[i];
+
+		if (reading.in_comment) {
+			reading.in_comment = c != '}';
+			++i;
+		} else if (c == '{') {
+			reading.in_comment = true;
+			++i;
+		} else if (c == ';') {
+			// comment up to the end of the line
+			return;
+		} else if (c == '(') {
+			reading.variation_depth += 1;
+			++i;
+		} else if (c == ')') {
+			reading.variation_depth = std::max(0, reading.variation_depth - 1);
+			++i;
+		} else if (isspace(static_cast<unsigned char>(c))) {
+			++i;
+		} else {
+			const size_t end = std::min(line.find_first_of(" \t{}();", i), line.size());
+
+			if (reading.variation_depth == 0) {
+				if (!reading.started) {
+					start_game(reading);
+				}
+
+				reading.in_moves = true;
+				read_token(reading, chunk, line.substr(i, end - i));
+			}
+
+			i = end;
+		}
+	}
+}
+
+Chunk pgn::parse(const char *begin, const char *end)
+{
+	Chunk chunk = {{}, 0};
+	Reading reading;
+	std::string line;
+
+	reading.started = false;
+	reading.in_comment = false;
+	reading.variation_depth = 0;
+
+	for (const char *p = begin; p < end;) {
+		const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+		const char *line_end = newline ? newline : end;
+
+		line.assign(p, line_end);
+		p = line_end + 1;
+
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+
+		if (!line.empty() && line[0] == '%') {
+			continue;
+		}
+
+		if (!line.empty() && line[0] == '[' && !reading.in_comment) {
+			// tags after moves belong to the next game
+			if (reading.started && reading.in_moves) {
+				finish_game(reading, chunk);
+			}
+
+			if (!reading.started) {
+				start_game(reading);
+			}
+
+			read_tag(reading, line);
+			continue;
+		}
+
+		read_moves(reading, chunk, line);
+	}
+
+	finish_game(reading, chunk);
+	return chunk;
+}
+
+const char *pgn::next_game(const char *begin, const char *end, const char *from)
+{
+	if (from <= begin) {
+		return begin;
+	}
+
+	// a game begins with a tag line that does not follow another
+	// tag line
+
+	for (const char *p = from - 1; p < end;) {
+		const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+
+		if (!newline || newline + 1 >= end) {
+			return end;
+		}
+
+		const char *line = newline + 1;
+
+		if (*line == '[') {
+			const char *previous = newline;
+
+			while (previous > begin && previous[-1] != '\n') {
+				--previous;
+			}
+
+			while (previous < newline && isspace(static_cast<unsigned char>(*previous))) {
+				++previous;
+			}
+
+			if (previous == newline || *previous != '[') {
+				return line;
+			}
+		}
+
+		p = line;
+	}
+
+	return end;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "archive.hh"
+#include "chess.hh"
+
+//
+// Reading games in Portable Game Notation.
+//
+// Only games that start from the initial board are read. Moves in
+// standard algebraic notation (SAN) get decoded with the move
+// generator; castling, en passant and promotions, which it does
+// not know, are decoded here.
+//
+
+namespace pgn
+{
+	/**
+	 * A game read from PGN.
+	 */
+	struct Game
+	{
+		archive::Result result;
+		std::vector<archive::Move> moves;
+	};
+
+	/**
+	 * Games read from a piece of PGN text.
+	 */
+	struct Chunk
+	{
+		std::vector<Game> games;
+
+		// games left out because they start from another board,
+		// have a move that could not be decoded or are longer
+		// than archive::MAX_MOVES
+		size_t skipped;
+	};
+
+	/**
+	 * Decode san, a move of current_player on board. Throws
+	 * std::invalid_argument if it is malformed, not possible or
+	 * fits more than one move.
+	 */
+	archive::Move parse_san(const chess::Board &board, chess::Color current_player, const std::string &san);
+
+	/**
+	 * Read all games in [begin, end), which has to start at the
+	 * beginning of a game.
+	 */
+	Chunk parse(const char *begin, const char *end);
+
+	/**
+	 * Return the beginning of the first game in [begin, end) that
+	 * starts at from or after it, or end if there is none. Pieces
+	 * of text split this way can be parsed independently.
+	 */
+	const char *next_game(const char *begin, const char *end, const char *from);
+};
@@ -2,6 +2,10 @@
 
 using namespace chess;
 
+Piece::Piece() : color(Color::White), kind(Kind::King), present(false)
+{
+}
+
 Piece::Piece(const Piece &other) : color(other.color), kind(other.kind), present(other.present)
 {
 }
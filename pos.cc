@@ -70,6 +70,11 @@ bool Pos::on_board() const
 	return in_range(this->x) && in_range(this->y);
 }
 
+uint64_t Pos::bit() const
+{
+	return uint64_t(1) << (this->x + 8 * this->y);
+}
+
 std::ostream &operator<<(std::ostream &os, const chess::Pos &pos)
 {
 	const int x = static_cast<int>(pos.x);
@@ -0,0 +1,159 @@
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "record.hh"
+
+using namespace chess;
+using namespace record;
+
+static const char MAGIC[8] = {'L', 'U', 'S', 'H', 'G', 'A', 'M', 'E'};
+static constexpr uint16_t VERSION = 1;
+static constexpr size_t HEADER_SIZE = 32;
+static constexpr size_t PLY_SIZE = 6;
+
+static void fail_with_message(const char *funcname, const char *path, const char *message)
+{
+	fprintf(stderr, "lushin: record: %s: %s: %s\n", funcname, path, message);
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_message(path, message) fail_with_message(__func__, path, message)
+
+static void put_u16(uint8_t *bytes, uint16_t value)
+{
+	bytes[0] = static_cast<uint8_t>(value);
+	bytes[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static void put_u32(uint8_t *bytes, uint32_t value)
+{
+	put_u16(bytes, static_cast<uint16_t>(value));
+	put_u16(bytes + 2, static_cast<uint16_t>(value >> 16));
+}
+
+static void put_u64(uint8_t *bytes, uint64_t value)
+{
+	put_u32(bytes, static_cast<uint32_t>(value));
+	put_u32(bytes + 4, static_cast<uint32_t>(value >> 32));
+}
+
+static uint16_t read_u16(const uint8_t *bytes)
+{
+	return static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t *bytes)
+{
+	return static_cast<uint32_t>(read_u16(bytes)) | static_cast<uint32_t>(read_u16(bytes + 2)) << 16;
+}
+
+static uint64_t read_u64(const uint8_t *bytes)
+{
+	return read_u32(bytes) | static_cast<uint64_t>(read_u32(bytes + 4)) << 32;
+}
+
+void record::append(const char *path, const Game &game)
+{
+	assert(game.plies.size() <= MAX_PLIES);
+
+	// everything goes out with a single write, so that a game
+	// that fails to get written leaves no trace in the file
+	std::vector<uint8_t> bytes(HEADER_SIZE + game.plies.size() * PLY_SIZE);
+
+	memcpy(bytes.data(), MAGIC, sizeof(MAGIC));
+	put_u16(&bytes[8], VERSION);
+	bytes[10] = static_cast<uint8_t>(game.engine);
+	put_u32(&bytes[12], static_cast<uint32_t>(game.plies.size()));
+	put_u64(&bytes[16], game.seed);
+	put_u32(&bytes[24], static_cast<uint32_t>(game.depth));
+	put_u32(&bytes[28], static_cast<uint32_t>(game.millis));
+
+	for (size_t i = 0; i < game.plies.size(); ++i) {
+		uint8_t *ply = &bytes[HEADER_SIZE + i * PLY_SIZE];
+
+		put_u16(ply, game.plies[i].move);
+		put_u32(ply + 2, game.plies[i].micros);
+	}
+
+	FILE *file = fopen(path, "ab");
+
+	if (!file) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	const bool ok = fwrite(bytes.data(), bytes.size(), 1, file) == 1;
+
+	if (fclose(file) || !ok) {
+		fail_with_message(path, strerror(errno));
+	}
+}
+
+std::vector<Game> record::load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+
+	if (!file) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	std::vector<uint8_t> bytes;
+	uint8_t buf[4096];
+
+	for (size_t n; (n = fread(buf, 1, sizeof(buf), file)) > 0;) {
+		bytes.insert(bytes.end(), buf, buf + n);
+	}
+
+	if (ferror(file)) {
+		fail_with_message(path, strerror(errno));
+	}
+
+	fclose(file);
+
+	std::vector<Game> games;
+	size_t offset = 0;
+
+	while (offset < bytes.size()) {
+		const uint8_t *header = &bytes[offset];
+
+		if (bytes.size() - offset < HEADER_SIZE || memcmp(header, MAGIC, sizeof(MAGIC))) {
+			fail_with_message(path, "not a recording");
+		}
+
+		if (read_u16(header + 8) != VERSION) {
+			fail_with_message(path, "unknown recording version");
+		}
+
+		if (header[10] > static_cast<uint8_t>(Color::White)) {
+			fail_with_message(path, "bad color of the computer");
+		}
+
+		const size_t nplies = read_u32(header + 12);
+
+		if ((bytes.size() - offset - HEADER_SIZE) / PLY_SIZE < nplies) {
+			fail_with_message(path, "game does not fit the file");
+		}
+
+		Game game;
+
+		game.engine = static_cast<Color>(header[10]);
+		game.seed = read_u64(header + 16);
+		game.depth = static_cast<int>(read_u32(header + 24));
+		game.millis = read_u32(header + 28);
+		game.plies.resize(nplies);
+
+		for (size_t i = 0; i < nplies; ++i) {
+			const uint8_t *ply = header + HEADER_SIZE + i * PLY_SIZE;
+
+			game.plies[i].move = read_u16(ply);
+			game.plies[i].micros = read_u32(ply + 2);
+		}
+
+		games.push_back(std::move(game));
+		offset += HEADER_SIZE + nplies * PLY_SIZE;
+	}
+
+	return games;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "archive.hh"
+#include "chess.hh"
+
+//
+// Recordings of games played against the computer, so that they
+// can be replayed later with lushin-replay.
+//
+// A recording file is any number of games one after the other,
+// each written in one go when the game ends, so that a file never
+// holds half a game. Every game is laid out as
+//
+//   header   8 bytes "LUSHGAME", uint16 version, uint8 color of
+//            the computer, uint8 zero, uint32 number of plies,
+//            uint64 seed of the engine, uint32 depth limit,
+//            uint32 time limit in ms
+//   plies    per ply an archive::Move and the uint32 time in
+//            microseconds the computer took to pick it, 0 for
+//            moves of the human
+//
+// with all numbers little endian. All games start from the
+// initial board with White to move.
+//
+
+namespace record
+{
+	struct Ply
+	{
+		archive::Move move;
+		uint32_t micros;
+	};
+
+	struct Game
+	{
+		// which side the computer played
+		chess::Color engine;
+
+		// seed of the engine, see engine::Options
+		uint64_t seed;
+
+		// limits the computer thought with for each move
+		int depth;
+		uint64_t millis;
+
+		std::vector<Ply> plies;
+	};
+
+	/**
+	 * Append game to the recording file at path, creating it if
+	 * needed. Exits the program if the file can not be written.
+	 */
+	void append(const char *path, const Game &game);
+
+	/**
+	 * Read all games of the recording file at path. Exits the
+	 * program if the file can not be read or is not a recording.
+	 */
+	std::vector<Game> load(const char *path);
+
+	/**
+	 * Longest game a recording can hold, in plies.
+	 */
+	static constexpr size_t MAX_PLIES = UINT32_MAX;
+};
@@ -0,0 +1,144 @@
+//
+// Replay recorded games as a latency benchmark, see record.hh.
+//
+// usage: lushin-replay [-d DEPTH] [-m MILLIS] FILE...
+//
+// Every game of every FILE is played again from the start. At
+// each position where the computer moved, the engine picks a move
+// again with the limits of the recording, or DEPTH and MILLIS if
+// given, and the recorded move is played either way so that the
+// replay stays on the recorded game. Each game gets a new engine
+// with the seed it was played with, just like the game window
+// has one engine per game.
+//
+// Prints as JSON how many moves were replayed, how many of them
+// came out different from the recording and the 50th, 95th and
+// 99th percentile of the time per move in microseconds, both as
+// recorded and as replayed. Games get replayed one at a time so
+// that the timings do not disturb each other.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "archive.hh"
+#include "engine.hh"
+#include "record.hh"
+#include "timer.hh"
+
+/**
+ * Return the p-th percentile of sorted by the nearest rank
+ * method, or 0 if sorted is empty.
+ */
+static uint64_t percentile(const std::vector<uint64_t> &sorted, int p)
+{
+	if (sorted.empty()) {
+		return 0;
+	}
+
+	const size_t rank = (sorted.size() * p + 99) / 100;
+	return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+static void print_percentiles(const char *name, std::vector<uint64_t> &micros, bool last)
+{
+	std::sort(micros.begin(), micros.end());
+
+	printf("  \"%s\": {\"p50\": %llu, \"p95\": %llu, \"p99\": %llu}%s\n", name,
+	       static_cast<unsigned long long>(percentile(micros, 50)),
+	       static_cast<unsigned long long>(percentile(micros, 95)),
+	       static_cast<unsigned long long>(percentile(micros, 99)),
+	       last ? "" : ",");
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr, "usage: %s [-d DEPTH] [-m MILLIS] FILE...\n", argv0);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	int depth = 0;
+	long long millis = -1;
+	std::vector<const char *> inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+			depth = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+			millis = std::max(0LL, atoll(argv[++i]));
+		} else if (argv[i][0] == '-') {
+			usage(argv[0]);
+		} else {
+			inputs.push_back(argv[i]);
+		}
+	}
+
+	if (inputs.empty()) {
+		usage(argv[0]);
+	}
+
+	size_t ngames = 0;
+	size_t nmoves = 0;
+	size_t ndiffering = 0;
+	std::vector<uint64_t> recorded;
+	std::vector<uint64_t> replayed;
+
+	for (const char *input : inputs) {
+		for (const record::Game &game : record::load(input)) {
+			engine::Options options;
+			options.seed = game.seed;
+
+			auto engine = std::make_unique<engine::Engine>(options);
+
+			search::Limits limits = {game.depth, game.millis};
+
+			if (depth > 0) {
+				limits.depth = depth;
+			}
+
+			if (millis >= 0) {
+				limits.millis = static_cast<uint64_t>(millis);
+			}
+
+			for (const record::Ply &ply : game.plies) {
+				const chess::Move move = archive::decode(ply.move);
+
+				if (!chess::is_valid_move(engine->board(), engine->current_player(), move)) {
+					fprintf(stderr, "lushin-replay: %s: game %zu: invalid move %s\n", input, ngames,
+					        chess::format_move(move).c_str());
+					exit(EXIT_FAILURE);
+				}
+
+				if (engine->current_player() == game.engine) {
+					const uint64_t start = timer::current_micros();
+					const search::Result result = engine->think(limits);
+
+					replayed.push_back(timer::current_micros() - start);
+					recorded.push_back(ply.micros);
+
+					nmoves += 1;
+					ndiffering += !result.move || *result.move != move;
+				}
+
+				engine->play(move);
+			}
+
+			ngames += 1;
+		}
+	}
+
+	printf("{\n");
+	printf("  \"games\": %zu,\n", ngames);
+	printf("  \"moves\": %zu,\n", nmoves);
+	printf("  \"differing\": %zu,\n", ndiffering);
+	printf("  \"differing_rate\": %.4f,\n", nmoves ? static_cast<double>(ndiffering) / nmoves : 0.0);
+	print_percentiles("recorded_micros", recorded, false);
+	print_percentiles("replayed_micros", replayed, true);
+	printf("}\n");
+}
@@ -1,48 +1,66 @@
+#include <optional>
 #include <stdexcept>
 
+#include "attacks.hh"
 #include "chess.hh"
+#include "nnue.hh"
+#include "pawns.hh"
+#include "stats.hh"
+#include "weights.hh"
 
 using namespace chess;
 
-static int absolute_score_piece(const Piece &piece)
+int chess::piece_value(Kind kind)
 {
-	switch (piece.kind) {
-	case Kind::King:
-		return 18;
-	case Kind::Queen:
-		return 9;
-	case Kind::Rook:
-		return 5;
-	case Kind::Bishop:
-		return 3;
-	case Kind::Knight:
-		return 3;
-	case Kind::Pawn:
-		return 1;
-	default:
-		return 0;
-	}
+	return weights::PIECE_VALUES[static_cast<size_t>(kind)];
 }
 
-static int score_piece(const Piece &piece, Color current_player)
+/**
+ * Return where the king of color is, if it is on the board.
+ */
+static std::optional<Pos> king_pos(const attacks::Map &map, Color color)
 {
-	const int absolute = absolute_score_piece(piece);
+	const uint64_t king = map.pieces[static_cast<size_t>(color)][static_cast<size_t>(Kind::King)];
 
-	if (piece.color == current_player) {
-		return absolute;
-	} else {
-		return (-1) * absolute;
+	if (!king) {
+		return std::nullopt;
 	}
+
+	const int i = __builtin_ctzll(king);
+	return Pos(i % 8, i / 8);
 }
 
 int chess::score(const Board &board, Color current_player)
 {
-	int accumulated = 0;
+	stats::count(stats::Counter::EvalCalls);
+
+	// the network knows about material; it gets updated with
+	// each move, so this is cheap
+	int accumulated = nnue::evaluate(board.accumulator(), current_player);
+
+	// one pass over the board for all terms that depend on
+	// which cells are attacked, and for finding the kings
+	const attacks::Map map = attacks::compute(board);
+
+	// pawn structure only changes with pawn moves and captures,
+	// so it is nearly always in the table already
+
+	const pawns::Entry &entry = pawns::local().probe(board);
+	int white_score = entry.score + attacks::evaluate(map);
 
-	board.for_each([&] (const Pos &pos, const Piece &piece) {
-		(void) pos;
-		accumulated += score_piece(piece, current_player);
-	});
+	if (const auto king = king_pos(map, Color::White)) {
+		white_score += pawns::shield(entry, Color::White, *king);
+	}
+
+	if (const auto king = king_pos(map, Color::Black)) {
+		white_score -= pawns::shield(entry, Color::Black, *king);
+	}
+
+	if (current_player == Color::White) {
+		accumulated += white_score;
+	} else {
+		accumulated -= white_score;
+	}
 
 	return accumulated;
 }
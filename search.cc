@@ -0,0 +1,824 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iterator>
+
+#include "choice.hh"
+#include "search.hh"
+#include "stats.hh"
+#include "trace.hh"
+#include "timer.hh"
+
+using namespace chess;
+using namespace search;
+
+/**
+ * How often (in nodes) to look at the clock and Limits::cancel.
+ */
+static constexpr uint64_t NODES_BETWEEN_CLOCK_CHECKS = 1024;
+
+/**
+ * Score of one pawn, see chess::score. Margins below are given in
+ * multiples of it.
+ */
+static constexpr int PAWN = 100;
+
+/**
+ * Null move pruning: how many plies less to search after passing,
+ * and the shallowest depth it is tried at.
+ */
+static constexpr int NULL_MOVE_REDUCTION = 2;
+static constexpr int NULL_MOVE_MIN_DEPTH = 3;
+
+/**
+ * Late move reductions: quiet moves from this index on get
+ * searched less deep, but only at depth LMR_MIN_DEPTH or more.
+ */
+static constexpr size_t LMR_MIN_INDEX = 3;
+static constexpr int LMR_MIN_DEPTH = 3;
+
+/**
+ * Near the leaves, quiet moves get skipped if the static score
+ * plus this margin (indexed by depth) can not reach alpha.
+ */
+static constexpr int FUTILITY_MARGINS[] = {0, 2 * PAWN, 4 * PAWN};
+static constexpr int FUTILITY_MAX_DEPTH = 2;
+
+/**
+ * Near the leaves, positions whose static score is this much
+ * per ply below alpha only get a quiescence search.
+ */
+static constexpr int RAZOR_MARGIN = 3 * PAWN;
+static constexpr int RAZOR_MAX_DEPTH = 2;
+
+/**
+ * History scores get halved once one of them passes this.
+ */
+static constexpr int32_t HISTORY_MAX = 1 << 20;
+
+/**
+ * Aspiration windows: from ASPIRATION_MIN_DEPTH on, the root gets
+ * searched with a window of this size around the score of the
+ * last iteration. It doubles on every fail until it passes
+ * ASPIRATION_MAX_WINDOW, then the window is opened all the way.
+ */
+static constexpr int ASPIRATION_WINDOW = PAWN / 2;
+static constexpr int ASPIRATION_MAX_WINDOW = 8 * PAWN;
+static constexpr int ASPIRATION_MIN_DEPTH = 4;
+
+bool search::is_mate_score(int score)
+{
+	return std::abs(score) >= MATE - static_cast<int>(arena::MAX_PLY);
+}
+
+/**
+ * Return the key for current_player to move on board.
+ */
+static uint64_t key_for(const Board &board, Color current_player)
+{
+	return board.hash() ^ chess::zobrist_key(current_player);
+}
+
+/**
+ * Mate scores are relative to the root. Stored in the table,
+ * they need to be relative to the position itself.
+ */
+static int score_to_table(int score, int ply)
+{
+	if (score >= MATE - static_cast<int>(arena::MAX_PLY)) {
+		return score + ply;
+	}
+
+	if (score <= -MATE + static_cast<int>(arena::MAX_PLY)) {
+		return score - ply;
+	}
+
+	return score;
+}
+
+static int score_from_table(int score, int ply)
+{
+	if (score >= MATE - static_cast<int>(arena::MAX_PLY)) {
+		return score - ply;
+	}
+
+	if (score <= -MATE + static_cast<int>(arena::MAX_PLY)) {
+		return score + ply;
+	}
+
+	return score;
+}
+
+/**
+ * Return whether current_player has anything besides pawns and the
+ * king. Without, passing might well be the best move (zugzwang),
+ * so null move pruning would give wrong results.
+ */
+static bool has_pieces(const Board &board, Color current_player)
+{
+	for (uint8_t x = 0; x < 8; ++x) {
+		for (uint8_t y = 0; y < 8; ++y) {
+			const Piece &piece = board.at({x, y});
+
+			if (piece.present && piece.color == current_player &&
+			    piece.kind != Kind::King && piece.kind != Kind::Pawn) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static int32_t &history_of(movepick::History &history, const Move &move)
+{
+	return history.scores[move.from.x + 8 * move.from.y][move.to.x + 8 * move.to.y];
+}
+
+/**
+ * Return whether captured is the king, which means the game is
+ * over.
+ */
+static bool took_king(const std::optional<Piece> &captured)
+{
+	return captured && captured->kind == Kind::King;
+}
+
+Search::Search(tt::Table &table, evalcache::Cache &eval_cache, choice::Generator &generator)
+	: m_table(table), m_eval_cache(eval_cache), m_generator(generator), m_previous_pv_length(0), m_following_pv(false),
+	  m_nodes(0), m_deadline(0), m_cancel(nullptr), m_progress(nullptr), m_stopped(false)
+{
+	std::fill(std::begin(this->m_nkillers), std::end(this->m_nkillers), 0);
+	std::fill(std::begin(this->m_pv_length), std::end(this->m_pv_length), 0);
+	this->clear_history();
+}
+
+Result Search::run(const Board &board, Color current_player, const Limits &limits)
+{
+	return this->analyze(board, current_player, limits, 1);
+}
+
+Result Search::analyze(const Board &board, Color current_player, const Limits &limits, size_t nlines)
+{
+	TRACE_SCOPE("Search::analyze");
+
+	assert(limits.depth > 0);
+	assert(nlines > 0);
+
+	this->m_nodes = 0;
+	this->m_stopped = false;
+	this->m_deadline = limits.millis ? timer::current_millis() + limits.millis : 0;
+	this->m_cancel = limits.cancel;
+	this->m_progress = limits.progress;
+	this->m_previous_pv_length = 0;
+	this->m_following_pv = false;
+
+	std::fill(std::begin(this->m_nkillers), std::end(this->m_nkillers), 0);
+	this->age_history();
+
+	Result result = {std::nullopt, 0, 0, 0, {}, {}};
+
+	arena::Frame frame;
+	Board root = board;
+
+	const arena::MoveList moves = frame.moves(root, current_player);
+
+	if (this->m_progress) {
+		this->m_progress->begin();
+	}
+
+	if (moves.empty()) {
+		if (this->m_progress) {
+			this->m_progress->end(0);
+		}
+
+		return result;
+	}
+
+	// moves that score the same get picked in random order; this
+	// keeps the computer from playing the same game over and over
+	choice::shuffle(this->m_generator, moves.begin(), moves.size());
+	result.move = moves[0];
+	result.pv = {moves[0]};
+
+	nlines = std::min(nlines, moves.size());
+
+	const int max_depth = std::min(limits.depth, static_cast<int>(arena::MAX_PLY) - 1);
+
+	// lines of the last completed iteration and of the current one
+	std::vector<Line> lines;
+	std::vector<Line> found;
+
+	for (int depth = 1; depth <= max_depth; ++depth) {
+		TRACE_SCOPE("search iteration");
+
+		const uint64_t iteration_start = stats::ENABLED ? timer::current_micros() : 0;
+
+		found.clear();
+
+		for (size_t i = 0; i < nlines; ++i) {
+			// moves of the lines before this one stay in front
+			// and are left out
+			const arena::MoveList rest(moves.begin() + i, moves.size() - i);
+			const Line *previous = i < lines.size() ? &lines[i] : nullptr;
+
+			// best move of this line in the last iteration goes
+			// first, and its line gets followed
+			if (previous) {
+				Move *last_best = std::find(rest.begin(), rest.end(), previous->move);
+
+				if (last_best != rest.end()) {
+					std::swap(*last_best, rest[0]);
+				}
+
+				std::copy(previous->pv.begin(), previous->pv.end(), this->m_previous_pv);
+				this->m_previous_pv_length = previous->pv.size();
+			} else {
+				this->m_previous_pv_length = 0;
+			}
+
+			// no line can be better than the one before it
+			const int upper = i == 0 ? INFINITE : found[i - 1].score + 1;
+
+			std::optional<Move> best_move;
+			const int score = this->search_line(root, current_player, rest, frame, depth, previous, upper, best_move);
+
+			if (this->m_stopped) {
+				break;
+			}
+
+			std::swap(*std::find(rest.begin(), rest.end(), *best_move), rest[0]);
+			found.push_back(Line{*best_move, score, {this->m_pv[0], this->m_pv[0] + this->m_pv_length[0]}});
+		}
+
+		if (this->m_stopped) {
+			break;
+		}
+
+		if (stats::ENABLED) {
+			stats::record_iteration(depth, timer::current_micros() - iteration_start);
+		}
+
+		lines.swap(found);
+
+		result.move = lines[0].move;
+		result.score = lines[0].score;
+		result.depth = depth;
+		result.pv = lines[0].pv;
+
+		if (this->m_progress) {
+			this->m_progress->completed(depth, result.score, result.pv, this->m_nodes);
+		}
+
+		this->m_table.store(key_for(root, current_player), depth, score_to_table(result.score, 0), tt::Bound::Exact,
+		                    result.move);
+
+		// no reason to look further once the outcomes are certain
+		const bool all_mates = std::all_of(lines.begin(), lines.end(), [] (const Line &line) {
+			return is_mate_score(line.score);
+		});
+
+		if (all_mates) {
+			break;
+		}
+	}
+
+	result.nodes = this->m_nodes;
+	result.lines = std::move(lines);
+
+	if (this->m_progress) {
+		this->m_progress->end(this->m_nodes);
+	}
+
+	return result;
+}
+
+int Search::search_line(Board &root, Color current_player, const arena::MoveList &moves, arena::Frame &frame,
+                        int depth, const Line *previous, int upper, std::optional<Move> &best_move)
+{
+	// aspiration window: expect about the same score as last
+	// time; if that turns out wrong, search again with a wider
+	// window. The window never goes past upper unless the score
+	// does.
+
+	int delta = ASPIRATION_WINDOW;
+	int alpha = -INFINITE;
+	int beta = upper;
+
+	if (previous && depth >= ASPIRATION_MIN_DEPTH && !is_mate_score(previous->score)) {
+		alpha = previous->score - delta;
+		beta = std::min(previous->score + delta, upper);
+
+		if (alpha >= beta) {
+			alpha = beta - delta;
+		}
+	}
+
+	for (;;) {
+		const int score = this->search_root(root, current_player, moves, frame, depth, alpha, beta, best_move);
+
+		if (this->m_stopped) {
+			return score;
+		}
+
+		if (score <= alpha) {
+			alpha = delta >= ASPIRATION_MAX_WINDOW ? -INFINITE : score - delta;
+		} else if (score >= beta) {
+			beta = delta >= ASPIRATION_MAX_WINDOW || beta >= upper ? INFINITE : std::min(score + delta, upper);
+			std::swap(*std::find(moves.begin(), moves.end(), *best_move), moves[0]);
+		} else {
+			return score;
+		}
+
+		delta *= 2;
+	}
+}
+
+int Search::search_root(Board &root, Color current_player, const arena::MoveList &moves, arena::Frame &frame,
+                        int depth, int alpha, int beta, std::optional<Move> &best_move)
+{
+	int best_score = -INFINITE;
+	bool first = true;
+
+	this->m_pv_length[0] = 0;
+	this->m_following_pv = this->m_previous_pv_length > 0;
+
+	for (const Move &move : moves) {
+		const auto captured = frame.make(root, move);
+		const Color opponent = swap_color(current_player);
+
+		this->m_pv_length[1] = 0;
+
+		int score;
+
+		if (took_king(captured)) {
+			score = MATE;
+		} else if (first) {
+			score = -this->alpha_beta(root, opponent, depth - 1, 1, -beta, -alpha, true);
+		} else {
+			score = -this->alpha_beta(root, opponent, depth - 1, 1, -alpha - 1, -alpha, true);
+
+			if (score > alpha && score < beta && !this->m_stopped) {
+				score = -this->alpha_beta(root, opponent, depth - 1, 1, -beta, -alpha, true);
+			}
+		}
+
+		frame.unmake(root);
+
+		this->m_following_pv = false;
+		first = false;
+
+		if (this->m_stopped) {
+			break;
+		}
+
+		if (score > best_score) {
+			best_score = score;
+			best_move = move;
+		}
+
+		if (score > alpha) {
+			alpha = score;
+			this->update_pv(0, move);
+		}
+
+		if (alpha >= beta) {
+			break;
+		}
+	}
+
+	return best_score;
+}
+
+int Search::alpha_beta(Board &board, Color current_player, int depth, int ply, int alpha, int beta, bool allow_null)
+{
+	if (depth <= 0) {
+		return this->quiesce(board, current_player, ply, alpha, beta);
+	}
+
+	this->m_nodes += 1;
+	stats::count(stats::Counter::Nodes);
+
+	if (this->should_stop()) {
+		return 0;
+	}
+
+	if (ply >= static_cast<int>(arena::MAX_PLY) - 1) {
+		return this->evaluate(board, current_player);
+	}
+
+	const bool pv_node = beta - alpha > 1;
+	const uint64_t key = key_for(board, current_player);
+	std::optional<Move> hash_move;
+
+	stats::count(stats::Counter::TableProbes);
+
+	if (const auto entry = this->m_table.probe(key)) {
+		stats::count(stats::Counter::TableHits);
+		hash_move = entry->move;
+
+		if (entry->depth >= depth) {
+			const int score = score_from_table(entry->score, ply);
+
+			const bool cutoff =
+				entry->bound == tt::Bound::Exact ||
+				(entry->bound == tt::Bound::Lower && score >= beta) ||
+				(entry->bound == tt::Bound::Upper && score <= alpha);
+
+			if (cutoff) {
+				stats::count(stats::Counter::TableCutoffs);
+				return score;
+			}
+		}
+	}
+
+	// the first line searched is the best line of the last
+	// iteration, as far as it goes
+	if (this->m_following_pv) {
+		if (static_cast<size_t>(ply) < this->m_previous_pv_length) {
+			hash_move = this->m_previous_pv[ply];
+		} else {
+			this->m_following_pv = false;
+		}
+	}
+
+	const int static_score = this->evaluate(board, current_player);
+	const bool near_mate = is_mate_score(alpha) || is_mate_score(beta);
+
+	// razoring: far behind close to the leaves, only captures
+	// could possibly help
+	if (depth <= RAZOR_MAX_DEPTH && !near_mate && static_score + RAZOR_MARGIN * depth <= alpha) {
+		const int score = this->quiesce(board, current_player, ply, alpha, alpha + 1);
+
+		if (this->m_stopped) {
+			return 0;
+		}
+
+		if (score <= alpha) {
+			return score;
+		}
+	}
+
+	// null move pruning: if passing still beats beta, a real
+	// move will too; passing while in check loses the king and
+	// so never prunes anything
+	if (allow_null && !pv_node && depth >= NULL_MOVE_MIN_DEPTH && !near_mate &&
+	    static_score >= beta && has_pieces(board, current_player)) {
+		const int reduction = NULL_MOVE_REDUCTION + (depth >= 6 ? 1 : 0);
+		const int score = -this->alpha_beta(board, swap_color(current_player), depth - 1 - reduction,
+		                                    ply + 1, -beta, -beta + 1, false);
+
+		if (this->m_stopped) {
+			return 0;
+		}
+
+		if (score >= beta) {
+			return beta;
+		}
+	}
+
+	const bool futile = depth <= FUTILITY_MAX_DEPTH && !near_mate &&
+	                    static_score + FUTILITY_MARGINS[depth] <= alpha;
+
+	arena::Frame frame;
+	movepick::Picker picker(frame, board, current_player, hash_move, this->m_killers[ply], this->m_nkillers[ply],
+	                        this->m_history[static_cast<size_t>(current_player)]);
+
+	const int original_alpha = alpha;
+	int best_score = -INFINITE;
+	std::optional<Move> best_move;
+	size_t move_index = 0;
+	bool pruned = false;
+
+	while (const auto move = picker.next()) {
+		const bool quiet = !board.at(move->to).present;
+
+		// futility pruning: a quiet move does not change the
+		// score enough to matter
+		if (futile && quiet && best_move) {
+			pruned = true;
+			move_index += 1;
+			continue;
+		}
+
+		const auto captured = frame.make(board, *move);
+		const Color opponent = swap_color(current_player);
+
+		this->m_pv_length[ply + 1] = 0;
+
+		int score;
+
+		if (took_king(captured)) {
+			score = MATE - ply;
+		} else if (move_index == 0) {
+			score = -this->alpha_beta(board, opponent, depth - 1, ply + 1, -beta, -alpha, true);
+		} else if (depth >= LMR_MIN_DEPTH && move_index >= LMR_MIN_INDEX && picker.picking_quiets()) {
+			// late move reductions: late quiet moves rarely turn
+			// out best, so first check with a shallower null
+			// window search whether they beat alpha at all; more
+			// so for late moves that never caused a cutoff
+			int reduction = 1;
+
+			if (move_index >= 2 * LMR_MIN_INDEX && depth >= 6) {
+				reduction += 1;
+			}
+
+			if (history_of(this->m_history[static_cast<size_t>(current_player)], *move) == 0) {
+				reduction += 1;
+			}
+
+			reduction = std::min(reduction, depth - 2);
+
+			score = -this->alpha_beta(board, opponent, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, true);
+
+			if (score > alpha && !this->m_stopped) {
+				score = this->scout(board, opponent, depth, ply, alpha, beta);
+			}
+		} else {
+			score = this->scout(board, opponent, depth, ply, alpha, beta);
+		}
+
+		frame.unmake(board);
+		this->m_following_pv = false;
+
+		if (this->m_stopped) {
+			return 0;
+		}
+
+		if (score > best_score) {
+			best_score = score;
+			best_move = move;
+		}
+
+		if (score > alpha) {
+			alpha = score;
+			this->update_pv(ply, *move);
+		}
+
+		if (alpha >= beta) {
+			stats::count_cutoff(move_index);
+
+			if (!captured) {
+				this->remember_killer(ply, *move);
+				this->remember_history(current_player, *move, depth);
+			}
+
+			break;
+		}
+
+		move_index += 1;
+	}
+
+	// everything except the first move got pruned; we only know
+	// that this is not good enough
+	if (pruned && best_score <= alpha) {
+		return best_score;
+	}
+
+	// not being able to move at all counts as lost, the same way
+	// is_check_mated sees it
+	if (!best_move) {
+		return -MATE + ply;
+	}
+
+	tt::Bound bound = tt::Bound::Exact;
+
+	if (best_score <= original_alpha) {
+		bound = tt::Bound::Upper;
+	} else if (best_score >= beta) {
+		bound = tt::Bound::Lower;
+	}
+
+	this->m_table.store(key, depth, score_to_table(best_score, ply), bound, best_move);
+
+	return best_score;
+}
+
+int Search::scout(Board &board, Color opponent, int depth, int ply, int alpha, int beta)
+{
+	// principal variation search: after the first move, only
+	// prove that a move is no better than alpha, which is
+	// cheaper; only if that fails is the full window needed
+
+	int score = -this->alpha_beta(board, opponent, depth - 1, ply + 1, -alpha - 1, -alpha, true);
+
+	if (score > alpha && score < beta && !this->m_stopped) {
+		score = -this->alpha_beta(board, opponent, depth - 1, ply + 1, -beta, -alpha, true);
+	}
+
+	return score;
+}
+
+void Search::update_pv(int ply, const Move &move)
+{
+	Move *line = this->m_pv[ply];
+	const Move *child = this->m_pv[ply + 1];
+	const size_t child_length = this->m_pv_length[ply + 1];
+
+	line[0] = move;
+	std::copy(child, child + child_length, line + 1);
+
+	this->m_pv_length[ply] = child_length + 1;
+}
+
+int Search::evaluate(const Board &board, Color current_player)
+{
+	const uint64_t key = key_for(board, current_player);
+
+	stats::count(stats::Counter::EvalCacheProbes);
+
+	if (const auto score = this->m_eval_cache.probe(key)) {
+		stats::count(stats::Counter::EvalCacheHits);
+		return *score;
+	}
+
+	const int score = chess::score(board, current_player);
+	this->m_eval_cache.store(key, score);
+
+	return score;
+}
+
+int Search::quiesce(Board &board, Color current_player, int ply, int alpha, int beta)
+{
+	this->m_nodes += 1;
+	stats::count(stats::Counter::QuiescenceNodes);
+
+	if (this->should_stop()) {
+		return 0;
+	}
+
+	// the player to move can always decide to not take anything
+	const int stand_pat = this->evaluate(board, current_player);
+
+	if (stand_pat >= beta || ply >= static_cast<int>(arena::MAX_PLY) - 1) {
+		return stand_pat;
+	}
+
+	if (stand_pat > alpha) {
+		alpha = stand_pat;
+	}
+
+	arena::Frame frame;
+	movepick::Picker picker(frame, board, current_player);
+
+	int best_score = stand_pat;
+
+	while (const auto move = picker.next()) {
+		const auto captured = frame.make(board, *move);
+
+		int score;
+
+		if (took_king(captured)) {
+			score = MATE - ply;
+		} else {
+			score = -this->quiesce(board, swap_color(current_player), ply + 1, -beta, -alpha);
+		}
+
+		frame.unmake(board);
+
+		if (this->m_stopped) {
+			return 0;
+		}
+
+		if (score > best_score) {
+			best_score = score;
+		}
+
+		if (score > alpha) {
+			alpha = score;
+		}
+
+		if (alpha >= beta) {
+			break;
+		}
+	}
+
+	return best_score;
+}
+
+bool Search::should_stop()
+{
+	if (this->m_stopped) {
+		return true;
+	}
+
+	if (this->m_nodes % NODES_BETWEEN_CLOCK_CHECKS != 0) {
+		return false;
+	}
+
+	if (this->m_deadline && timer::current_millis() >= this->m_deadline) {
+		this->m_stopped = true;
+	}
+
+	if (this->m_cancel && this->m_cancel->load(std::memory_order_relaxed)) {
+		this->m_stopped = true;
+	}
+
+	if (this->m_progress) {
+		this->m_progress->visited(this->m_nodes);
+	}
+
+	return this->m_stopped;
+}
+
+Progress::Progress() : m_snapshot{false, 0, 0, {}, 0, 0}, m_started(0)
+{
+}
+
+Snapshot Progress::snapshot() const
+{
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	Snapshot snapshot = this->m_snapshot;
+
+	if (snapshot.running) {
+		snapshot.millis = timer::current_millis() - this->m_started;
+	}
+
+	return snapshot;
+}
+
+void Progress::begin()
+{
+	const uint64_t now = timer::current_millis();
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	this->m_snapshot = Snapshot{true, 0, 0, {}, 0, 0};
+	this->m_started = now;
+}
+
+void Progress::visited(uint64_t nodes)
+{
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	this->m_snapshot.nodes = nodes;
+}
+
+void Progress::completed(int depth, int score, const std::vector<Move> &pv, uint64_t nodes)
+{
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	this->m_snapshot.depth = depth;
+	this->m_snapshot.score = score;
+	this->m_snapshot.pv = pv;
+	this->m_snapshot.nodes = nodes;
+}
+
+void Progress::end(uint64_t nodes)
+{
+	const uint64_t now = timer::current_millis();
+
+	std::lock_guard<std::mutex> lock(this->m_mutex);
+	this->m_snapshot.running = false;
+	this->m_snapshot.nodes = nodes;
+	this->m_snapshot.millis = now - this->m_started;
+}
+
+void Search::remember_killer(int ply, const Move &move)
+{
+	Move *killers = this->m_killers[ply];
+	size_t &nkillers = this->m_nkillers[ply];
+
+	if (nkillers > 0 && killers[0] == move) {
+		return;
+	}
+
+	// newest killer goes first, the oldest one drops out
+
+	for (size_t i = movepick::NKILLERS - 1; i > 0; --i) {
+		killers[i] = killers[i - 1];
+	}
+
+	killers[0] = move;
+	nkillers = std::min(nkillers + 1, movepick::NKILLERS);
+}
+
+void Search::remember_history(Color current_player, const Move &move, int depth)
+{
+	movepick::History &history = this->m_history[static_cast<size_t>(current_player)];
+	int32_t &score = history_of(history, move);
+
+	// deeper cutoffs say more about a move
+	score += depth * depth;
+
+	if (score > HISTORY_MAX) {
+		this->age_history();
+	}
+}
+
+void Search::age_history()
+{
+	for (movepick::History &history : this->m_history) {
+		for (auto &row : history.scores) {
+			for (int32_t &score : row) {
+				score /= 2;
+			}
+		}
+	}
+}
+
+void Search::clear_history()
+{
+	for (movepick::History &history : this->m_history) {
+		for (auto &row : history.scores) {
+			std::fill(std::begin(row), std::end(row), 0);
+		}
+	}
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "arena.hh"
+#include "chess.hh"
+#include "choice.hh"
+#include "evalcache.hh"
+#include "movepick.hh"
+#include "tt.hh"
+
+namespace search
+{
+	/**
+	 * Score bigger than any score a search can return.
+	 */
+	static constexpr int INFINITE = 1000000;
+
+	/**
+	 * Score for taking the opponents king right away. Taking
+	 * the king n plies in the future scores MATE - n.
+	 */
+	static constexpr int MATE = 100000;
+
+	/**
+	 * Return whether score means one side can force taking
+	 * the king of the other.
+	 */
+	bool is_mate_score(int score);
+
+	class Progress;
+
+	/**
+	 * When to stop searching.
+	 */
+	struct Limits
+	{
+		// maximum depth in plies
+		int depth;
+
+		// maximum time in ms; 0 means no time limit
+		uint64_t millis;
+
+		// if given, the search stops soon after another thread
+		// sets it
+		const std::atomic<bool> *cancel = nullptr;
+
+		// if given, the search keeps it up to date for other
+		// threads to watch
+		Progress *progress = nullptr;
+	};
+
+	/**
+	 * How far a search got, as seen from another thread.
+	 */
+	struct Snapshot
+	{
+		// whether the search is still running
+		bool running;
+
+		// depth, score and best line of the last completed
+		// iteration; depth is 0 before the first one completes
+		int depth;
+		int score;
+		std::vector<chess::Move> pv;
+
+		// positions visited and time spent so far
+		uint64_t nodes;
+		uint64_t millis;
+	};
+
+	/**
+	 * What a running search found so far. The search writes it
+	 * once per iteration and every few thousand positions, so
+	 * the lock is hardly ever contended; any thread may take a
+	 * snapshot at any time.
+	 */
+	class Progress
+	{
+	public:
+		Progress();
+
+		Snapshot snapshot() const;
+
+		// called by the search
+		void begin();
+		void visited(uint64_t nodes);
+		void completed(int depth, int score, const std::vector<chess::Move> &pv, uint64_t nodes);
+		void end(uint64_t nodes);
+
+	private:
+		mutable std::mutex m_mutex;
+		Snapshot m_snapshot;
+		uint64_t m_started;
+	};
+
+	/**
+	 * One of the lines found by Search::analyze.
+	 */
+	struct Line
+	{
+		// first move of the line
+		chess::Move move;
+
+		// exact score of move from the point of view of the
+		// player to move
+		int score;
+
+		// moves both players are expected to play, starting
+		// with move
+		std::vector<chess::Move> pv;
+	};
+
+	/**
+	 * What a search found out.
+	 */
+	struct Result
+	{
+		// best move found; only empty if there was no move at all
+		std::optional<chess::Move> move;
+
+		// score of move from the point of view of the player to move
+		int score;
+
+		// depth of the last completed iteration
+		int depth;
+
+		// number of positions visited
+		uint64_t nodes;
+
+		// moves both players are expected to play, starting
+		// with move
+		std::vector<chess::Move> pv;
+
+		// best lines, each with a different first move, best
+		// first; lines[0] is move, score and pv again. Empty if
+		// not even the first iteration completed
+		std::vector<Line> lines;
+	};
+
+	/**
+	 * An iterative deepening alpha-beta search. Moves are tried
+	 * in the order handed out by movepick::Picker, all but the
+	 * first with a null window first (principal variation
+	 * search). Null move
+	 * pruning, late move reductions, futility pruning and
+	 * razoring skip lines that are unlikely to matter. One
+	 * Search must only be used by one thread at a time.
+	 */
+	class Search
+	{
+	public:
+		/**
+		 * Create a new search that remembers results in table
+		 * and static scores in eval_cache, and picks between
+		 * equally good moves with generator.
+		 */
+		Search(tt::Table &table, evalcache::Cache &eval_cache, choice::Generator &generator);
+
+		/**
+		 * Find the best move for current_player on board.
+		 */
+		Result run(const chess::Board &board, chess::Color current_player, const Limits &limits);
+
+		/**
+		 * Find the nlines best moves for current_player on board
+		 * (or all, if there are fewer), each with its own line
+		 * and exact score (MultiPV). In every iteration, the
+		 * best move is searched as in run; each next line is
+		 * searched without the moves of the lines before it,
+		 * with a window ending at the score of the line before.
+		 * All lines share the transposition table, so they
+		 * cost far less than nlines separate searches.
+		 */
+		Result analyze(const chess::Board &board, chess::Color current_player, const Limits &limits, size_t nlines);
+
+	private:
+		tt::Table &m_table;
+		evalcache::Cache &m_eval_cache;
+		choice::Generator &m_generator;
+
+		chess::Move m_killers[arena::MAX_PLY][movepick::NKILLERS];
+		size_t m_nkillers[arena::MAX_PLY];
+
+		// indexed by color
+		movepick::History m_history[2];
+
+		// triangular table of best lines; m_pv[ply] is the best
+		// line found from ply on in the current iteration
+		chess::Move m_pv[arena::MAX_PLY][arena::MAX_PLY];
+		size_t m_pv_length[arena::MAX_PLY];
+
+		// best line of the last iteration; while m_following_pv,
+		// the search is still on it
+		chess::Move m_previous_pv[arena::MAX_PLY];
+		size_t m_previous_pv_length;
+		bool m_following_pv;
+
+		uint64_t m_nodes;
+		uint64_t m_deadline;
+		const std::atomic<bool> *m_cancel;
+		Progress *m_progress;
+		bool m_stopped;
+
+		int search_line(chess::Board &root, chess::Color current_player, const arena::MoveList &moves,
+		                arena::Frame &frame, int depth, const Line *previous, int upper, std::optional<chess::Move> &best_move);
+		int search_root(chess::Board &root, chess::Color current_player, const arena::MoveList &moves,
+		                arena::Frame &frame, int depth, int alpha, int beta, std::optional<chess::Move> &best_move);
+		int alpha_beta(chess::Board &board, chess::Color current_player, int depth, int ply, int alpha, int beta, bool allow_null);
+		int scout(chess::Board &board, chess::Color opponent, int depth, int ply, int alpha, int beta);
+		void update_pv(int ply, const chess::Move &move);
+		int evaluate(const chess::Board &board, chess::Color current_player);
+		int quiesce(chess::Board &board, chess::Color current_player, int ply, int alpha, int beta);
+		bool should_stop();
+		void remember_killer(int ply, const chess::Move &move);
+		void remember_history(chess::Color current_player, const chess::Move &move, int depth);
+		void age_history();
+		void clear_history();
+	};
+};
@@ -0,0 +1,810 @@
+//
+// Analysis server.
+//
+// usage: lushin-server [-t THREADS] [-q QUEUE] [-m MEGABYTES] SOCKET
+//
+// Listens on the Unix domain socket SOCKET for clients sending one
+// JSON object per line:
+//
+//   {"id": 1, "fen": "<FEN>", "depth": 12, "millis": 500, "multipv": 3}
+//
+// Only fen is required. depth defaults to 64 plies and multipv,
+// the number of best moves wanted, to 1. millis is the deadline
+// of the request, counted from when it arrives, so time spent
+// waiting for a worker counts too; it defaults to 1000, and 0
+// means no deadline. {"id": 1, "cancel": true} cancels all
+// requests of the same client with that id.
+//
+// A fixed pool of THREADS workers (one per core by default)
+// searches the requests, sharing one transposition table of
+// MEGABYTES and one evaluation cache, which stay warm between
+// requests. At most QUEUE requests wait for a worker; more get
+// turned down. Each request gets one line back as soon as its
+// search is done, so responses may come in a different order than
+// the requests. id is passed back as is:
+//
+//   {"id": 1, "depth": 12, "nodes": 123456, "lines": [
+//     {"move": "e2e4", "score": 30, "pv": ["e2e4", "e7e5", ...]}, ...]}
+//
+// or {"id": 1, "error": "<message>"}. Scores are in centipawns for
+// the player to move. Moves name the cell a piece moves from and
+// the one it moves to.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "chess.hh"
+#include "choice.hh"
+#include "evalcache.hh"
+#include "nnue.hh"
+#include "search.hh"
+#include "timer.hh"
+#include "tt.hh"
+
+using namespace chess;
+
+/**
+ * Defaults for the command line.
+ */
+static constexpr size_t DEFAULT_QUEUE = 64;
+static constexpr size_t DEFAULT_TABLE_MEGABYTES = 64;
+
+/**
+ * Memory for the shared evaluation cache.
+ */
+static constexpr size_t EVAL_CACHE_MEGABYTES = 16;
+
+/**
+ * Defaults for requests.
+ */
+static constexpr int DEFAULT_DEPTH = 64;
+static constexpr uint64_t DEFAULT_MILLIS = 1000;
+
+/**
+ * Clients sending longer lines get disconnected.
+ */
+static constexpr size_t MAX_LINE = 64 * 1024;
+
+/**
+ * Writing a response gives up on a client that does not read
+ * after this many seconds.
+ */
+static constexpr int SEND_TIMEOUT_SECONDS = 5;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void fail_with_errno(const char *funcname, const char *what)
+{
+	fprintf(stderr, "lushin: server: %s: %s: %s\n", funcname, what, strerror(errno));
+	exit(EXIT_FAILURE);
+}
+
+#define fail_with_errno(what) fail_with_errno(__func__, what)
+
+struct Job;
+
+/**
+ * One connected client.
+ */
+struct Connection
+{
+	explicit Connection(int fd) : fd(fd), closed(false)
+	{
+	}
+
+	~Connection()
+	{
+		close(this->fd);
+	}
+
+	int fd;
+
+	// bytes read but not handled yet; only used by the thread
+	// doing the IO
+	std::string input;
+
+	// guards writes to fd and everything below
+	std::mutex mutex;
+
+	// requests that have not been answered yet
+	std::vector<std::shared_ptr<Job>> jobs;
+
+	// set once the client went away; nothing gets written then
+	bool closed;
+};
+
+/**
+ * One search request.
+ */
+struct Job
+{
+	std::shared_ptr<Connection> connection;
+
+	// JSON text of the id given by the client, or null
+	std::string id;
+
+	Position position;
+	int depth;
+	size_t multipv;
+
+	// in ms like timer::current_millis; 0 means none
+	uint64_t deadline;
+
+	std::atomic<bool> cancelled{false};
+};
+
+/**
+ * Requests waiting for a worker.
+ */
+class Queue
+{
+public:
+	explicit Queue(size_t capacity) : m_capacity(capacity), m_closed(false)
+	{
+	}
+
+	/**
+	 * Add jobs from the first one on as long as there is room,
+	 * all under one lock. Return how many were added.
+	 */
+	size_t push(const std::vector<std::shared_ptr<Job>> &jobs)
+	{
+		size_t n;
+
+		{
+			std::lock_guard<std::mutex> lock(this->m_mutex);
+
+			n = std::min(jobs.size(), this->m_capacity - this->m_jobs.size());
+			this->m_jobs.insert(this->m_jobs.end(), jobs.begin(), jobs.begin() + n);
+		}
+
+		if (n == 1) {
+			this->m_cv.notify_one();
+		} else if (n > 1) {
+			this->m_cv.notify_all();
+		}
+
+		return n;
+	}
+
+	/**
+	 * Wait for a job and return it, or nullptr once the queue
+	 * is closed and empty.
+	 */
+	std::shared_ptr<Job> pop()
+	{
+		std::unique_lock<std::mutex> lock(this->m_mutex);
+
+		this->m_cv.wait(lock, [&] { return this->m_closed || !this->m_jobs.empty(); });
+
+		if (this->m_jobs.empty()) {
+			return nullptr;
+		}
+
+		std::shared_ptr<Job> job = std::move(this->m_jobs.front());
+		this->m_jobs.pop_front();
+
+		return job;
+	}
+
+	/**
+	 * Let the workers finish the jobs left and then stop.
+	 */
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->m_mutex);
+			this->m_closed = true;
+		}
+
+		this->m_cv.notify_all();
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::deque<std::shared_ptr<Job>> m_jobs;
+	size_t m_capacity;
+	bool m_closed;
+};
+
+/**
+ * A value of a request. Strings keep their decoded text in text;
+ * json is the value as it was written.
+ */
+struct Value
+{
+	bool is_string;
+	std::string text;
+	std::string json;
+};
+
+using Fields = std::map<std::string, Value>;
+
+static void skip_space(const std::string &line, size_t &i)
+{
+	while (i < line.size() && strchr(" \t\r\n", line[i])) {
+		++i;
+	}
+}
+
+static void expect(const std::string &line, size_t &i, char c)
+{
+	skip_space(line, i);
+
+	if (i >= line.size() || line[i] != c) {
+		throw std::invalid_argument(std::string("expected '") + c + "'");
+	}
+
+	++i;
+}
+
+static std::string parse_string(const std::string &line, size_t &i)
+{
+	expect(line, i, '"');
+
+	std::string text;
+
+	while (i < line.size() && line[i] != '"') {
+		char c = line[i++];
+
+		if (c == '\\') {
+			if (i >= line.size()) {
+				break;
+			}
+
+			switch (c = line[i++]) {
+			case 'n':
+				c = '\n';
+				break;
+			case 't':
+				c = '\t';
+				break;
+			case 'r':
+				c = '\r';
+				break;
+			case '"':
+			case '\\':
+			case '/':
+				break;
+			default:
+				throw std::invalid_argument("unsupported escape in string");
+			}
+		}
+
+		text += c;
+	}
+
+	expect(line, i, '"');
+	return text;
+}
+
+static Value parse_value(const std::string &line, size_t &i)
+{
+	skip_space(line, i);
+	const size_t begin = i;
+
+	if (i < line.size() && line[i] == '"') {
+		std::string text = parse_string(line, i);
+		return Value{true, std::move(text), line.substr(begin, i - begin)};
+	}
+
+	while (i < line.size() && (isalnum(static_cast<unsigned char>(line[i])) || strchr("+-.", line[i]))) {
+		++i;
+	}
+
+	const std::string json = line.substr(begin, i - begin);
+
+	if (json == "true" || json == "false" || json == "null") {
+		return Value{false, json, json};
+	}
+
+	char *end;
+	strtod(json.c_str(), &end);
+
+	if (json.empty() || *end || !(isdigit(static_cast<unsigned char>(json[0])) || json[0] == '-')) {
+		throw std::invalid_argument("values must be strings, numbers, true, false or null");
+	}
+
+	return Value{false, json, json};
+}
+
+/**
+ * Parse a JSON object without nested objects or arrays.
+ */
+static Fields parse_object(const std::string &line)
+{
+	Fields fields;
+	size_t i = 0;
+
+	expect(line, i, '{');
+	skip_space(line, i);
+
+	if (i < line.size() && line[i] == '}') {
+		++i;
+	} else {
+		for (;;) {
+			std::string key = parse_string(line, i);
+			expect(line, i, ':');
+			fields[std::move(key)] = parse_value(line, i);
+
+			skip_space(line, i);
+
+			if (i < line.size() && line[i] == ',') {
+				++i;
+				continue;
+			}
+
+			expect(line, i, '}');
+			break;
+		}
+	}
+
+	skip_space(line, i);
+
+	if (i != line.size()) {
+		throw std::invalid_argument("trailing characters after object");
+	}
+
+	return fields;
+}
+
+static long long get_integer(const Fields &fields, const char *name, long long fallback, long long min, long long max)
+{
+	const auto it = fields.find(name);
+
+	if (it == fields.end()) {
+		return fallback;
+	}
+
+	const std::string &json = it->second.json;
+	char *end;
+	const long long value = strtoll(json.c_str(), &end, 10);
+
+	if (it->second.is_string || json.empty() || *end || value < min || value > max) {
+		throw std::invalid_argument(std::string(name) + " must be an integer from " + std::to_string(min) +
+		                            " to " + std::to_string(max));
+	}
+
+	return value;
+}
+
+static std::string quote(const std::string &text)
+{
+	std::string json = "\"";
+
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			json += '\\';
+			json += c;
+		} else if (c == '\n') {
+			json += "\\n";
+		} else if (static_cast<unsigned char>(c) >= 0x20) {
+			json += c;
+		}
+	}
+
+	return json + "\"";
+}
+
+static std::string format_error(const std::string &id, const std::string &message)
+{
+	return "{\"id\": " + id + ", \"error\": " + quote(message) + "}\n";
+}
+
+static std::string format_result(const std::string &id, const search::Result &result)
+{
+	std::string json = "{\"id\": " + id + ", \"depth\": " + std::to_string(result.depth) +
+	                   ", \"nodes\": " + std::to_string(result.nodes) + ", \"lines\": [";
+
+	for (size_t i = 0; i < result.lines.size(); ++i) {
+		const search::Line &line = result.lines[i];
+
+		json += i ? ", " : "";
+		json += "{\"move\": \"" + format_move(line.move) + "\", \"score\": " + std::to_string(line.score) + ", \"pv\": [";
+
+		for (size_t j = 0; j < line.pv.size(); ++j) {
+			json += j ? ", \"" : "\"";
+			json += format_move(line.pv[j]) + "\"";
+		}
+
+		json += "]}";
+	}
+
+	return json + "]}\n";
+}
+
+/**
+ * Write line to connection unless the client is gone. Must be
+ * called with the connection locked.
+ */
+static void send_locked(Connection &connection, const std::string &line)
+{
+	size_t written = 0;
+
+	while (!connection.closed && written < line.size()) {
+		const ssize_t n = send(connection.fd, line.data() + written, line.size() - written, MSG_NOSIGNAL);
+
+		if (n > 0) {
+			written += n;
+		} else if (n == -1 && errno != EINTR) {
+			// gone or not reading; the IO thread notices soon
+			connection.closed = true;
+		}
+	}
+}
+
+static void send_line(Connection &connection, const std::string &line)
+{
+	std::lock_guard<std::mutex> lock(connection.mutex);
+	send_locked(connection, line);
+}
+
+/**
+ * Answer job and forget about it.
+ */
+static void finish(Job &job, const std::string &line)
+{
+	Connection &connection = *job.connection;
+	std::lock_guard<std::mutex> lock(connection.mutex);
+
+	const auto it = std::find_if(connection.jobs.begin(), connection.jobs.end(), [&] (const auto &other) {
+		return other.get() == &job;
+	});
+
+	if (it != connection.jobs.end()) {
+		connection.jobs.erase(it);
+	}
+
+	send_locked(connection, line);
+}
+
+static void run_job(search::Search &searcher, Job &job)
+{
+	if (job.cancelled) {
+		finish(job, format_error(job.id, "cancelled"));
+		return;
+	}
+
+	uint64_t millis = 0;
+
+	if (job.deadline) {
+		const uint64_t now = timer::current_millis();
+
+		if (now >= job.deadline) {
+			finish(job, format_error(job.id, "deadline passed while queued"));
+			return;
+		}
+
+		millis = job.deadline - now;
+	}
+
+	const search::Limits limits = {job.depth, millis, &job.cancelled};
+	const search::Result result =
+		searcher.analyze(job.position.board, job.position.current_player, limits, job.multipv);
+
+	if (job.cancelled) {
+		finish(job, format_error(job.id, "cancelled"));
+	} else {
+		finish(job, format_result(job.id, result));
+	}
+}
+
+static void work(Queue &queue, tt::Table &table, evalcache::Cache &eval_cache)
+{
+	// every worker picks between equal moves with the generator
+	// of its own thread
+	search::Search searcher(table, eval_cache, choice::local());
+
+	while (const std::shared_ptr<Job> job = queue.pop()) {
+		run_job(searcher, *job);
+	}
+}
+
+/**
+ * Handle one request line of connection. Search requests get added
+ * to batch instead of being queued right away.
+ */
+static void handle_line(const std::shared_ptr<Connection> &connection, const std::string &line,
+                        std::vector<std::shared_ptr<Job>> &batch)
+{
+	std::string id = "null";
+
+	try {
+		const Fields fields = parse_object(line);
+
+		if (const auto it = fields.find("id"); it != fields.end()) {
+			id = it->second.json;
+		}
+
+		if (const auto it = fields.find("cancel"); it != fields.end() && it->second.json == "true") {
+			std::lock_guard<std::mutex> lock(connection->mutex);
+
+			for (const std::shared_ptr<Job> &job : connection->jobs) {
+				if (job->id == id) {
+					job->cancelled = true;
+				}
+			}
+
+			return;
+		}
+
+		const auto fen = fields.find("fen");
+
+		if (fen == fields.end() || !fen->second.is_string) {
+			throw std::invalid_argument("fen missing");
+		}
+
+		auto job = std::make_shared<Job>();
+
+		job->connection = connection;
+		job->id = id;
+		job->position = chess::parse_fen(fen->second.text);
+		job->depth = get_integer(fields, "depth", DEFAULT_DEPTH, 1, arena::MAX_PLY - 1);
+		job->multipv = get_integer(fields, "multipv", 1, 1, chess::MAX_NEXT_MOVES);
+
+		const uint64_t millis = get_integer(fields, "millis", DEFAULT_MILLIS, 0, 24 * 60 * 60 * 1000);
+		job->deadline = millis ? timer::current_millis() + millis : 0;
+
+		batch.push_back(std::move(job));
+	} catch (const std::exception &e) {
+		send_line(*connection, format_error(id, e.what()));
+	}
+}
+
+/**
+ * Handle the complete lines read from connection. Return false if
+ * the client has to be dropped.
+ */
+static bool handle_input(Queue &queue, const std::shared_ptr<Connection> &connection)
+{
+	std::string &input = connection->input;
+	std::vector<std::shared_ptr<Job>> batch;
+
+	size_t begin = 0;
+	size_t end;
+
+	while ((end = input.find('\n', begin)) != std::string::npos) {
+		const std::string line = input.substr(begin, end - begin);
+		begin = end + 1;
+
+		if (line.find_first_not_of(" \t\r") != std::string::npos) {
+			handle_line(connection, line, batch);
+		}
+	}
+
+	input.erase(0, begin);
+
+	// all requests of one read go into the queue at once; the
+	// ones that do not fit are turned down
+	{
+		std::lock_guard<std::mutex> lock(connection->mutex);
+		connection->jobs.insert(connection->jobs.end(), batch.begin(), batch.end());
+	}
+
+	const size_t queued = queue.push(batch);
+
+	for (size_t i = queued; i < batch.size(); ++i) {
+		finish(*batch[i], format_error(batch[i]->id, "too many requests queued"));
+	}
+
+	if (input.size() > MAX_LINE) {
+		send_line(*connection, format_error("null", "line too long"));
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Cancel everything connection asked for and stop writing to it.
+ */
+static void drop(Connection &connection)
+{
+	std::lock_guard<std::mutex> lock(connection.mutex);
+
+	connection.closed = true;
+
+	for (const std::shared_ptr<Job> &job : connection.jobs) {
+		job->cancelled = true;
+	}
+}
+
+static int listen_on(const char *path)
+{
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		errno = ENAMETOOLONG;
+		fail_with_errno(path);
+	}
+
+	strcpy(address.sun_path, path);
+
+	// a socket left over from an earlier run would make bind fail
+	struct stat st;
+	if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+		unlink(path);
+	}
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+	if (fd == -1) {
+		fail_with_errno("socket");
+	}
+
+	if (bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == -1) {
+		fail_with_errno(path);
+	}
+
+	if (listen(fd, SOMAXCONN) == -1) {
+		fail_with_errno(path);
+	}
+
+	return fd;
+}
+
+static void serve(int listen_fd, Queue &queue)
+{
+	std::vector<std::shared_ptr<Connection>> connections;
+	std::vector<pollfd> fds;
+
+	while (!g_stop) {
+		fds.clear();
+		fds.push_back({listen_fd, POLLIN, 0});
+
+		for (const std::shared_ptr<Connection> &connection : connections) {
+			fds.push_back({connection->fd, POLLIN, 0});
+		}
+
+		if (poll(fds.data(), fds.size(), -1) == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			fail_with_errno("poll");
+		}
+
+		// connections that came in now are not in fds yet
+		const size_t nconnections = connections.size();
+
+		if (fds[0].revents & POLLIN) {
+			const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+			if (fd != -1) {
+				const timeval timeout = {SEND_TIMEOUT_SECONDS, 0};
+				setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+				connections.push_back(std::make_shared<Connection>(fd));
+			}
+		}
+
+		std::vector<bool> keep(connections.size(), true);
+
+		for (size_t i = 0; i < nconnections; ++i) {
+			if (!fds[i + 1].revents) {
+				continue;
+			}
+
+			const std::shared_ptr<Connection> &connection = connections[i];
+			char buffer[4096];
+			const ssize_t n = read(connection->fd, buffer, sizeof(buffer));
+
+			if (n == -1 && errno == EINTR) {
+				continue;
+			}
+
+			if (n <= 0) {
+				keep[i] = false;
+				continue;
+			}
+
+			connection->input.append(buffer, n);
+			keep[i] = handle_input(queue, connection);
+		}
+
+		for (size_t i = connections.size(); i-- > 0;) {
+			if (!keep[i]) {
+				drop(*connections[i]);
+				connections.erase(connections.begin() + i);
+			}
+		}
+	}
+
+	for (const std::shared_ptr<Connection> &connection : connections) {
+		drop(*connection);
+	}
+}
+
+static void stop(int)
+{
+	g_stop = 1;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr, "usage: %s [-t THREADS] [-q QUEUE] [-m MEGABYTES] SOCKET\n", argv0);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+	size_t queue_size = DEFAULT_QUEUE;
+	size_t megabytes = DEFAULT_TABLE_MEGABYTES;
+	const char *path = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			nthreads = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-q") && i + 1 < argc) {
+			queue_size = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+			megabytes = std::max(1, atoi(argv[++i]));
+		} else if (argv[i][0] == '-' || path) {
+			usage(argv[0]);
+		} else {
+			path = argv[i];
+		}
+	}
+
+	if (!path) {
+		usage(argv[0]);
+	}
+
+	// load the network now, so that a bad LUSHIN_NNUE shows
+	// before anyone connects
+	nnue::network();
+
+	tt::Table table(megabytes);
+	evalcache::Cache eval_cache(EVAL_CACHE_MEGABYTES);
+	Queue queue(queue_size);
+
+	const int listen_fd = listen_on(path);
+
+	// without SA_RESTART, so that poll returns
+	struct sigaction action = {};
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+
+	std::vector<std::thread> workers;
+
+	for (size_t i = 0; i < nthreads; ++i) {
+		workers.emplace_back(work, std::ref(queue), std::ref(table), std::ref(eval_cache));
+	}
+
+	fprintf(stderr, "listening on %s with %zu workers\n", path, nthreads);
+
+	serve(listen_fd, queue);
+
+	queue.close();
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	close(listen_fd);
+	unlink(path);
+}
@@ -0,0 +1,163 @@
+//
+// Check mate puzzles in bulk with the mate solver, see mate.hh.
+//
+// usage: lushin-solve [-t THREADS] [-n NODES] [-m MILLIS] [-s MEGABYTES] FILE
+//
+// Every line of FILE is a FEN followed by the number of moves to
+// mate in, for example:
+//
+//   6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1 1
+//
+// For each line, in the same order, one line is printed: "mate"
+// and the first move of the mate, "nomate", "unknown" if NODES
+// or MILLIS ran out first, or "error" if the line could not be
+// read, followed by the number of positions expanded. The player
+// to move is the attacker. Each thread has a table of MEGABYTES.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chess.hh"
+#include "mate.hh"
+#include "timer.hh"
+
+struct Puzzle
+{
+	std::string line;
+	std::string answer;
+};
+
+/**
+ * Solve the puzzle in line and return the answer to print.
+ */
+static std::string solve(mate::Solver &solver, const std::string &line, const mate::Limits &defaults)
+{
+	const size_t split = line.find_last_of(' ');
+
+	if (split == std::string::npos) {
+		return "error";
+	}
+
+	chess::Position position;
+	mate::Limits limits = defaults;
+
+	try {
+		position = chess::parse_fen(line.substr(0, split));
+		limits.moves = std::stoi(line.substr(split + 1));
+	} catch (const std::exception &) {
+		return "error";
+	}
+
+	if (limits.moves <= 0) {
+		return "error";
+	}
+
+	const mate::Result result = solver.solve(position.board, position.current_player, limits);
+	const std::string nodes = std::to_string(result.nodes);
+
+	switch (result.outcome) {
+	case mate::Outcome::Mate:
+		return "mate " + (result.move ? chess::format_move(*result.move) : "-") + " " + nodes;
+	case mate::Outcome::NoMate:
+		return "nomate " + nodes;
+	case mate::Outcome::Unknown:
+		break;
+	}
+
+	return "unknown " + nodes;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr, "usage: %s [-t THREADS] [-n NODES] [-m MILLIS] [-s MEGABYTES] FILE\n", argv0);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+	size_t megabytes = 16;
+	mate::Limits limits = {0, 0, 0};
+	const char *input = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			nthreads = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			limits.nodes = strtoull(argv[++i], nullptr, 10);
+		} else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+			limits.millis = strtoull(argv[++i], nullptr, 10);
+		} else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+			megabytes = std::max(1, atoi(argv[++i]));
+		} else if (argv[i][0] == '-' || input) {
+			usage(argv[0]);
+		} else {
+			input = argv[i];
+		}
+	}
+
+	if (!input) {
+		usage(argv[0]);
+	}
+
+	std::ifstream file(input);
+
+	if (!file) {
+		perror(input);
+		exit(EXIT_FAILURE);
+	}
+
+	std::vector<Puzzle> puzzles;
+
+	for (std::string line; std::getline(file, line);) {
+		if (!line.empty()) {
+			puzzles.push_back(Puzzle{line, ""});
+		}
+	}
+
+	const uint64_t start = timer::current_millis();
+
+	// every thread has its own solver, the puzzles get handed out
+	// one at a time
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> threads;
+
+	nthreads = std::min(nthreads, std::max<size_t>(1, puzzles.size()));
+
+	for (size_t t = 0; t < nthreads; ++t) {
+		threads.emplace_back([&] {
+			auto solver = std::make_unique<mate::Solver>(megabytes);
+
+			// the table is kept from puzzle to puzzle: what
+			// is proven stays true, and puzzles from the
+			// same game often share positions
+			for (size_t i; (i = next.fetch_add(1)) < puzzles.size();) {
+				puzzles[i].answer = solve(*solver, puzzles[i].line, limits);
+			}
+		});
+	}
+
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	size_t mates = 0;
+
+	for (const Puzzle &puzzle : puzzles) {
+		printf("%s\n", puzzle.answer.c_str());
+		mates += puzzle.answer.compare(0, 5, "mate ") == 0;
+	}
+
+	fprintf(stderr, "%zu puzzles, %zu mates, %.2f s\n", puzzles.size(), mates,
+	        (timer::current_millis() - start) / 1000.0);
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "stats.hh"
+
+using namespace stats;
+
+/**
+ * Blocks of all running threads and the sum of the blocks of all
+ * threads that exited. Only touched when a thread starts or stops
+ * counting and when reporting, never while counting.
+ */
+static std::mutex registry_mutex;
+static std::vector<Block *> registry;
+static Totals retired;
+
+static void add_block(Totals &totals, const Block &block)
+{
+	for (size_t i = 0; i < NCOUNTERS; ++i) {
+		totals.counters[i] += block.counters[i].load(std::memory_order_relaxed);
+	}
+
+	for (size_t i = 0; i < NCUTOFF_SLOTS; ++i) {
+		totals.cutoffs[i] += block.cutoffs[i].load(std::memory_order_relaxed);
+	}
+
+	for (size_t i = 0; i < MAX_ITERATIONS; ++i) {
+		totals.iteration_micros[i] += block.iteration_micros[i].load(std::memory_order_relaxed);
+		totals.iterations[i] += block.iterations[i].load(std::memory_order_relaxed);
+	}
+}
+
+static void clear_block(Block &block)
+{
+	for (auto &counter : block.counters) {
+		counter.store(0, std::memory_order_relaxed);
+	}
+
+	for (auto &counter : block.cutoffs) {
+		counter.store(0, std::memory_order_relaxed);
+	}
+
+	for (size_t i = 0; i < MAX_ITERATIONS; ++i) {
+		block.iteration_micros[i].store(0, std::memory_order_relaxed);
+		block.iterations[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+Registration::Registration()
+{
+	clear_block(this->block);
+
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	registry.push_back(&this->block);
+}
+
+Registration::~Registration()
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	add_block(retired, this->block);
+	registry.erase(std::find(registry.begin(), registry.end(), &this->block));
+}
+
+Totals stats::collect()
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	Totals totals = retired;
+
+	for (const Block *block : registry) {
+		add_block(totals, *block);
+	}
+
+	return totals;
+}
+
+void stats::reset()
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	retired = Totals{};
+
+	for (Block *block : registry) {
+		clear_block(*block);
+	}
+}
+
+void stats::write_json(FILE *fp, const Totals &totals)
+{
+	static const char *COUNTER_NAMES[NCOUNTERS] = {
+		"nodes", "qnodes", "tt_probes", "tt_hits", "tt_cutoffs",
+		"movegen_calls", "eval_calls", "eval_cache_probes", "eval_cache_hits",
+		"pawn_probes", "pawn_hits"
+	};
+
+	fprintf(fp, "{");
+
+	for (size_t i = 0; i < NCOUNTERS; ++i) {
+		fprintf(fp, "\"%s\": %llu, ", COUNTER_NAMES[i],
+		        static_cast<unsigned long long>(totals.counters[i]));
+	}
+
+	fprintf(fp, "\"beta_cutoffs_by_move\": [");
+
+	for (size_t i = 0; i < NCUTOFF_SLOTS; ++i) {
+		fprintf(fp, "%s%llu", i ? ", " : "", static_cast<unsigned long long>(totals.cutoffs[i]));
+	}
+
+	fprintf(fp, "], \"iterations\": [");
+
+	bool first = true;
+
+	for (size_t depth = 0; depth < MAX_ITERATIONS; ++depth) {
+		if (!totals.iterations[depth]) {
+			continue;
+		}
+
+		fprintf(fp, "%s{\"depth\": %zu, \"count\": %llu, \"micros\": %llu}",
+		        first ? "" : ", ", depth,
+		        static_cast<unsigned long long>(totals.iterations[depth]),
+		        static_cast<unsigned long long>(totals.iteration_micros[depth]));
+
+		first = false;
+	}
+
+	fprintf(fp, "]}\n");
+	fflush(fp);
+}
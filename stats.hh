@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * Counters are compiled in unless NDEBUG is defined. In a release
+ * build every function below that updates a counter is empty.
+ */
+#ifdef NDEBUG
+#define LUSHIN_STATS 0
+#else
+#define LUSHIN_STATS 1
+#endif
+
+namespace stats
+{
+	static constexpr bool ENABLED = LUSHIN_STATS;
+
+	/**
+	 * Events that get counted.
+	 */
+	enum class Counter : size_t
+	{
+		// positions visited by alpha-beta
+		Nodes = 0,
+
+		// positions visited by the quiescence search
+		QuiescenceNodes,
+
+		// lookups in the transposition table
+		TableProbes,
+
+		// lookups that found an entry
+		TableHits,
+
+		// lookups that ended the search of a position right away
+		TableCutoffs,
+
+		// calls to chess::next_moves
+		MovegenCalls,
+
+		// calls to chess::score
+		EvalCalls,
+
+		// lookups in the evaluation cache
+		EvalCacheProbes,
+
+		// lookups that found a score
+		EvalCacheHits,
+
+		// lookups in the pawn table
+		PawnProbes,
+
+		// lookups that found the pawns already evaluated
+		PawnHits,
+
+		Count
+	};
+
+	static constexpr size_t NCOUNTERS = static_cast<size_t>(Counter::Count);
+
+	/**
+	 * Beta cutoffs are counted by the index of the move that
+	 * caused them; everything from NCUTOFF_SLOTS - 1 on shares
+	 * the last slot.
+	 */
+	static constexpr size_t NCUTOFF_SLOTS = 8;
+
+	/**
+	 * Number of iterative deepening iterations that get timed.
+	 */
+	static constexpr size_t MAX_ITERATIONS = 128;
+
+	/**
+	 * Counters of one thread. Only the owning thread writes them,
+	 * so updates don't need to be atomic read-modify-writes. They
+	 * are atomics only so that another thread can read them while
+	 * they change.
+	 */
+	struct Block
+	{
+		std::atomic<uint64_t> counters[NCOUNTERS];
+		std::atomic<uint64_t> cutoffs[NCUTOFF_SLOTS];
+		std::atomic<uint64_t> iteration_micros[MAX_ITERATIONS];
+		std::atomic<uint64_t> iterations[MAX_ITERATIONS];
+	};
+
+	/**
+	 * The counters of all threads added up.
+	 */
+	struct Totals
+	{
+		uint64_t counters[NCOUNTERS];
+		uint64_t cutoffs[NCUTOFF_SLOTS];
+		uint64_t iteration_micros[MAX_ITERATIONS];
+		uint64_t iterations[MAX_ITERATIONS];
+	};
+
+	/**
+	 * Registers the Block of a thread while the thread runs.
+	 * When the thread exits, its counts are kept.
+	 */
+	class Registration
+	{
+	public:
+		Registration();
+		~Registration();
+
+		Registration(const Registration &other) = delete;
+		Registration &operator=(const Registration &other) = delete;
+
+		Block block;
+	};
+
+	inline thread_local Registration t_registration;
+
+	inline void add(std::atomic<uint64_t> &counter, uint64_t n)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Count one event.
+	 */
+	inline void count(Counter counter)
+	{
+		if constexpr (ENABLED) {
+			add(t_registration.block.counters[static_cast<size_t>(counter)], 1);
+		}
+	}
+
+	/**
+	 * Count a beta cutoff caused by the move tried at index.
+	 */
+	inline void count_cutoff(size_t index)
+	{
+		if constexpr (ENABLED) {
+			const size_t slot = index < NCUTOFF_SLOTS ? index : NCUTOFF_SLOTS - 1;
+			add(t_registration.block.cutoffs[slot], 1);
+		}
+	}
+
+	/**
+	 * Record that the iteration to depth took micros µs.
+	 */
+	inline void record_iteration(int depth, uint64_t micros)
+	{
+		if constexpr (ENABLED) {
+			if (depth >= 0 && static_cast<size_t>(depth) < MAX_ITERATIONS) {
+				add(t_registration.block.iteration_micros[depth], micros);
+				add(t_registration.block.iterations[depth], 1);
+			}
+		}
+	}
+
+	/**
+	 * Add up the counters of all threads, including those that
+	 * already exited.
+	 */
+	Totals collect();
+
+	/**
+	 * Set all counters back to zero. Counts done by other threads
+	 * at the same time may get lost.
+	 */
+	void reset();
+
+	/**
+	 * Write totals to fp as a single line of JSON.
+	 */
+	void write_json(FILE *fp, const Totals &totals);
+};
@@ -8,4 +8,9 @@ namespace timer
 	 * Return the current clock time in ms.
 	 */
 	uint64_t current_millis();
+
+	/**
+	 * Return the current clock time in µs.
+	 */
+	uint64_t current_micros();
 }
@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <vector>
+
+#include "trace.hh"
+
+using namespace trace;
+
+/**
+ * Every buffer ever handed out and those whose thread exited.
+ * A new thread reuses a free buffer before allocating another
+ * one, so threads that come and go (like the one the computer
+ * thinks on) don't keep adding to memory use. Only touched when
+ * a thread starts or stops tracing and at exit.
+ */
+static std::mutex buffers_mutex;
+static std::vector<Buffer *> buffers;
+static std::vector<Buffer *> free_buffers;
+
+static const char *DEFAULT_PATH = "lushin-trace.json";
+
+static void write_trace()
+{
+	const char *path = getenv("LUSHIN_TRACE_FILE");
+
+	if (!path) {
+		path = DEFAULT_PATH;
+	}
+
+	FILE *fp;
+	if (!(fp = fopen(path, "w"))) {
+		perror(path);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+
+	fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+
+	bool first = true;
+
+	for (const Buffer *buffer : buffers) {
+		const size_t count = buffer->count.load(std::memory_order_acquire);
+
+		for (size_t i = 0; i < count; ++i) {
+			const Event &event = buffer->events[i];
+
+			fprintf(fp, "%s\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %llu, \"dur\": %llu}",
+			        first ? "" : ",", event.name, buffer->tid,
+			        static_cast<unsigned long long>(event.begin_micros),
+			        static_cast<unsigned long long>(event.duration_micros));
+
+			first = false;
+		}
+
+		const size_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+
+		if (dropped) {
+			fprintf(stderr, "lushin: trace: dropped %zu spans of thread %u\n", dropped, buffer->tid);
+		}
+	}
+
+	fprintf(fp, "\n]}\n");
+
+	if (fclose(fp)) {
+		perror(path);
+	}
+}
+
+static Buffer *acquire_buffer()
+{
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+
+	if (!free_buffers.empty()) {
+		Buffer *buffer = free_buffers.back();
+		free_buffers.pop_back();
+		return buffer;
+	}
+
+	if (buffers.empty() && atexit(write_trace)) {
+		fprintf(stderr, "lushin: trace: atexit failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	Buffer *buffer = new Buffer;
+	buffer->tid = static_cast<uint32_t>(buffers.size() + 1);
+	buffer->count.store(0, std::memory_order_relaxed);
+	buffer->dropped.store(0, std::memory_order_relaxed);
+
+	buffers.push_back(buffer);
+	return buffer;
+}
+
+static void release_buffer(Buffer *buffer)
+{
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	free_buffers.push_back(buffer);
+}
+
+/**
+ * Hands the buffer of a thread back when the thread exits.
+ */
+struct Owner
+{
+	Buffer *buffer;
+
+	Owner() : buffer(acquire_buffer())
+	{
+	}
+
+	~Owner()
+	{
+		release_buffer(this->buffer);
+	}
+};
+
+Buffer &trace::local()
+{
+	static thread_local Owner owner;
+	return *owner.buffer;
+}
+
+uint64_t trace::now_micros()
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1) {
+		perror("clock_gettime");
+		exit(EXIT_FAILURE);
+	}
+
+	const uint64_t seconds = static_cast<uint64_t>(ts.tv_sec);
+	const uint64_t nsecs = static_cast<uint64_t>(ts.tv_nsec);
+
+	return seconds * 1000000ULL + nsecs / 1000ULL;
+}
+
+Span::Span(const char *name) : m_name(name), m_begin(now_micros())
+{
+}
+
+Span::~Span()
+{
+	const uint64_t end = now_micros();
+
+	Buffer &buffer = local();
+	const size_t count = buffer.count.load(std::memory_order_relaxed);
+
+	if (count == MAX_EVENTS) {
+		buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer.events[count] = Event{this->m_name, this->m_begin, end - this->m_begin};
+	buffer.count.store(count + 1, std::memory_order_release);
+}
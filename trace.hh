@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Tracing is only compiled in when LUSHIN_TRACE is defined. Then
+ * every span gets recorded and written out in Chrome trace_event
+ * format when the program exits, by default to lushin-trace.json
+ * or to the file named by the LUSHIN_TRACE_FILE environment
+ * variable. The result can be opened in Perfetto or about:tracing.
+ *
+ * Without LUSHIN_TRACE, TRACE_SCOPE expands to nothing.
+ */
+#ifdef LUSHIN_TRACE
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/**
+ * Record a span named name (a string literal) from here to the end
+ * of the enclosing scope.
+ */
+#define TRACE_SCOPE(name) trace::Span TRACE_CONCAT(trace_span_, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name)
+
+#endif
+
+namespace trace
+{
+	/**
+	 * Maximum number of spans recorded per thread. Spans past
+	 * that get dropped.
+	 */
+	static constexpr size_t MAX_EVENTS = 1 << 16;
+
+	/**
+	 * One finished span.
+	 */
+	struct Event
+	{
+		const char *name;
+		uint64_t begin_micros;
+		uint64_t duration_micros;
+	};
+
+	/**
+	 * The spans of one thread. Only the owning thread appends;
+	 * publishing the new count with release order makes the
+	 * event visible to the thread writing the trace, so no lock
+	 * is needed.
+	 */
+	struct Buffer
+	{
+		uint32_t tid;
+		std::atomic<size_t> count;
+		std::atomic<size_t> dropped;
+		Event events[MAX_EVENTS];
+	};
+
+	/**
+	 * Return the buffer of the calling thread. It gets allocated
+	 * on first use and lives until the program exits.
+	 */
+	Buffer &local();
+
+	/**
+	 * Return the time spans are measured in.
+	 */
+	uint64_t now_micros();
+
+	/**
+	 * Records the time from its creation until its destruction.
+	 */
+	class Span
+	{
+	public:
+		explicit Span(const char *name);
+		~Span();
+
+		Span(const Span &other) = delete;
+		Span &operator=(const Span &other) = delete;
+
+	private:
+		const char *m_name;
+		uint64_t m_begin;
+	};
+};
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cassert>
+
+#include "tt.hh"
+
+using namespace tt;
+
+/**
+ * Return the largest power of two that is not bigger than n.
+ */
+static size_t floor_power_of_two(size_t n)
+{
+	size_t power = 1;
+
+	while (power * 2 <= n) {
+		power *= 2;
+	}
+
+	return power;
+}
+
+//
+// Layout of the data word of a slot:
+//
+//   bits  0-31  score
+//   bits 32-39  depth
+//   bits 40-41  bound
+//   bit     42  whether there is a move
+//   bits 43-54  move, 3 bits each for from.x, from.y, to.x, to.y
+//   bit     63  set in every filled slot, so that empty slots,
+//               which are all zero, never match
+//
+
+static constexpr int DEPTH_SHIFT = 32;
+static constexpr int BOUND_SHIFT = 40;
+static constexpr int HAS_MOVE_SHIFT = 42;
+static constexpr int MOVE_SHIFT = 43;
+
+static constexpr uint64_t MOVE_MASK = uint64_t(0xfff) << MOVE_SHIFT;
+static constexpr uint64_t FILLED = uint64_t(1) << 63;
+
+static uint64_t pack_move(const std::optional<chess::Move> &move)
+{
+	if (!move) {
+		return 0;
+	}
+
+	const uint64_t bits = move->from.x | move->from.y << 3 | move->to.x << 6 | move->to.y << 9;
+	return uint64_t(1) << HAS_MOVE_SHIFT | bits << MOVE_SHIFT;
+}
+
+static std::optional<chess::Move> unpack_move(uint64_t data)
+{
+	if (!(data >> HAS_MOVE_SHIFT & 1)) {
+		return std::nullopt;
+	}
+
+	const uint64_t bits = data >> MOVE_SHIFT;
+
+	const chess::Pos from = {static_cast<uint8_t>(bits & 7), static_cast<uint8_t>(bits >> 3 & 7)};
+	const chess::Pos to = {static_cast<uint8_t>(bits >> 6 & 7), static_cast<uint8_t>(bits >> 9 & 7)};
+
+	return chess::Move{from, to};
+}
+
+Table::Table(size_t megabytes)
+	: m_slots(floor_power_of_two(megabytes * 1024 * 1024 / sizeof(Slot)))
+{
+}
+
+std::optional<Entry> Table::probe(uint64_t key) const
+{
+	const Slot &slot = this->m_slots[key & (this->m_slots.size() - 1)];
+
+	const uint64_t data = slot.data.load(std::memory_order_relaxed);
+	const uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+	if (!(data & FILLED) || (check ^ data) != key) {
+		return std::nullopt;
+	}
+
+	Entry entry;
+
+	entry.key = key;
+	entry.move = unpack_move(data);
+	entry.score = static_cast<int32_t>(static_cast<uint32_t>(data));
+	entry.depth = static_cast<int16_t>(data >> DEPTH_SHIFT & 0xff);
+	entry.bound = static_cast<Bound>(data >> BOUND_SHIFT & 3);
+
+	return entry;
+}
+
+void Table::store(uint64_t key, int depth, int score, Bound bound, const std::optional<chess::Move> &move)
+{
+	assert(depth >= 0 && depth <= 0xff);
+
+	Slot &slot = this->m_slots[key & (this->m_slots.size() - 1)];
+
+	uint64_t data = FILLED |
+		static_cast<uint32_t>(static_cast<int32_t>(score)) |
+		static_cast<uint64_t>(depth) << DEPTH_SHIFT |
+		static_cast<uint64_t>(bound) << BOUND_SHIFT |
+		pack_move(move);
+
+	// keep the best move we already know when the new result
+	// does not come with one
+	if (!move) {
+		const uint64_t old_data = slot.data.load(std::memory_order_relaxed);
+		const uint64_t old_check = slot.check.load(std::memory_order_relaxed);
+
+		if ((old_data & FILLED) && (old_check ^ old_data) == key) {
+			data |= old_data & (uint64_t(1) << HAS_MOVE_SHIFT | MOVE_MASK);
+		}
+	}
+
+	slot.check.store(key ^ data, std::memory_order_relaxed);
+	slot.data.store(data, std::memory_order_relaxed);
+}
+
+void Table::clear()
+{
+	for (Slot &slot : this->m_slots) {
+		slot.check.store(0, std::memory_order_relaxed);
+		slot.data.store(0, std::memory_order_relaxed);
+	}
+}
+
+size_t Table::size() const
+{
+	return this->m_slots.size();
+}
+
+int Table::permille() const
+{
+	const size_t n = std::min<size_t>(1000, this->m_slots.size());
+	size_t filled = 0;
+
+	for (size_t i = 0; i < n; ++i) {
+		filled += (this->m_slots[i].data.load(std::memory_order_relaxed) & FILLED) != 0;
+	}
+
+	return static_cast<int>(filled * 1000 / n);
+}
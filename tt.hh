@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "chess.hh"
+
+namespace tt
+{
+	/**
+	 * How the score stored in an entry relates to the real
+	 * score of the position.
+	 */
+	enum class Bound : uint8_t
+	{
+		// score is exact
+		Exact = 0,
+
+		// real score is at least score
+		Lower = 1,
+
+		// real score is at most score
+		Upper = 2
+	};
+
+	/**
+	 * What we know about one position from an earlier search.
+	 */
+	struct Entry
+	{
+		uint64_t key;
+		std::optional<chess::Move> move;
+		int32_t score;
+		int16_t depth;
+		Bound bound;
+	};
+
+	/**
+	 * A transposition table, that is a fixed size hash table of
+	 * search results. Each key maps to exactly one slot; newer
+	 * results replace older ones.
+	 *
+	 * Searches on several threads may share one Table without
+	 * locking. Like evalcache::Cache, each slot packs the entry
+	 * into one word and keeps the key XORed with it next to it,
+	 * so a slot torn by two threads writing at once just misses.
+	 */
+	class Table
+	{
+	public:
+		/**
+		 * Create a new table that uses about megabytes of memory.
+		 */
+		explicit Table(size_t megabytes);
+
+		Table(const Table &other) = delete;
+		Table &operator=(const Table &other) = delete;
+
+		/**
+		 * Return the entry stored for key, if any.
+		 */
+		std::optional<Entry> probe(uint64_t key) const;
+
+		/**
+		 * Remember a search result for key.
+		 */
+		void store(uint64_t key, int depth, int score, Bound bound, const std::optional<chess::Move> &move);
+
+		/**
+		 * Forget everything stored.
+		 */
+		void clear();
+
+		/**
+		 * Return the number of slots in the table.
+		 */
+		size_t size() const;
+
+		/**
+		 * Return how full the table is in permille, estimated
+		 * from the first thousand slots.
+		 */
+		int permille() const;
+
+	private:
+		struct Slot
+		{
+			std::atomic<uint64_t> check{0};
+			std::atomic<uint64_t> data{0};
+		};
+
+		std::vector<Slot> m_slots;
+	};
+};
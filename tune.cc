@@ -0,0 +1,571 @@
+//
+// Texel tuning of the weights in weights.hh.
+//
+// usage: lushin-tune [-t THREADS] [-n ITERATIONS] [-o OUTPUT] DATASET
+//
+// DATASET has one position per line: a FEN string followed by the
+// result of the game it came from, one of 1-0, 0-1, 1/2-1/2 or a
+// number in [0, 1], all from the point of view of White. The
+// tuner minimizes the squared difference between the results and
+// the sigmoid of the evaluation using Adam, then writes a new
+// weights.hh to OUTPUT (or stdout).
+//
+// The hand written evaluation is linear in its weights, so every
+// position gets boiled down to how often each term applies once
+// when loading; after that, iterations neither touch boards nor
+// allocate.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "attacks.hh"
+#include "chess.hh"
+#include "pawns.hh"
+#include "weights.hh"
+
+using namespace chess;
+
+/**
+ * Weights that get tuned, in this order: values of the pieces
+ * from Queen to Pawn (the king never changes hands), doubled and
+ * isolated pawn penalties, passed pawn bonuses, shield bonuses,
+ * mobility bonuses from Queen to Knight (kings and pawns have
+ * none), king attack bonuses from Queen to Pawn and the hanging
+ * piece penalty.
+ */
+static constexpr size_t NMATERIAL = 5;
+static constexpr size_t DOUBLED = NMATERIAL;
+static constexpr size_t ISOLATED = DOUBLED + 1;
+static constexpr size_t PASSED = ISOLATED + 1;
+static constexpr size_t SHIELD_NEAR = PASSED + pawns::NPASSED;
+static constexpr size_t SHIELD_FAR = SHIELD_NEAR + 1;
+static constexpr size_t NMOBILITY = 4;
+static constexpr size_t MOBILITY = SHIELD_FAR + 1;
+static constexpr size_t KING_ATTACK = MOBILITY + NMOBILITY;
+static constexpr size_t HANGING = KING_ATTACK + NMATERIAL;
+static constexpr size_t NWEIGHTS = HANGING + 1;
+
+/**
+ * Adam parameters. The learning rate is in centipawns.
+ */
+static constexpr double LEARNING_RATE = 1.0;
+static constexpr double BETA1 = 0.9;
+static constexpr double BETA2 = 0.999;
+static constexpr double EPSILON = 1e-8;
+
+/**
+ * One labelled position: for each weight, how often its term
+ * applies to White minus how often it applies to Black, and the
+ * result in half points for White.
+ */
+struct Sample
+{
+	int8_t features[NWEIGHTS];
+	uint8_t result;
+};
+
+/**
+ * Loss and gradient over a slice of the samples. Each worker has
+ * its own, padded so that workers don't share cache lines.
+ */
+struct alignas(64) Partial
+{
+	double loss;
+	double gradient[NWEIGHTS];
+};
+
+/**
+ * Lets the workers and the main thread wait for each other
+ * between the steps of an iteration.
+ */
+class Barrier
+{
+public:
+	explicit Barrier(size_t nthreads) : m_nthreads(nthreads), m_waiting(0), m_generation(0)
+	{
+	}
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(this->m_mutex);
+		const size_t generation = this->m_generation;
+
+		if (++this->m_waiting == this->m_nthreads) {
+			this->m_waiting = 0;
+			this->m_generation += 1;
+			this->m_cv.notify_all();
+			return;
+		}
+
+		this->m_cv.wait(lock, [&] { return this->m_generation != generation; });
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	size_t m_nthreads;
+	size_t m_waiting;
+	size_t m_generation;
+};
+
+static int8_t clamp_feature(int n)
+{
+	if (n < INT8_MIN || n > INT8_MAX) {
+		throw std::invalid_argument("term applies too often");
+	}
+
+	return static_cast<int8_t>(n);
+}
+
+static uint8_t parse_result(const std::string &token)
+{
+	if (token == "1-0") {
+		return 2;
+	}
+
+	if (token == "0-1") {
+		return 0;
+	}
+
+	if (token == "1/2-1/2") {
+		return 1;
+	}
+
+	size_t end;
+	const double value = std::stod(token, &end);
+
+	if (end != token.size() || value < 0 || value > 1) {
+		throw std::invalid_argument("bad result: " + token);
+	}
+
+	return static_cast<uint8_t>(std::lround(value * 2));
+}
+
+static Sample make_sample(const Board &board, uint8_t result)
+{
+	int features[NWEIGHTS] = {};
+
+	std::optional<Pos> kings[2];
+
+	board.for_each([&] (const Pos &pos, const Piece &piece) {
+		const int sign = piece.color == Color::White ? 1 : -1;
+
+		if (piece.kind == Kind::King) {
+			kings[static_cast<size_t>(piece.color)] = pos;
+		} else {
+			features[static_cast<size_t>(piece.kind) - 1] += sign;
+		}
+	});
+
+	const pawns::Entry entry = pawns::evaluate(board);
+	const attacks::Map map = attacks::compute(board);
+
+	for (Color color : {Color::White, Color::Black}) {
+		const int sign = color == Color::White ? 1 : -1;
+		const pawns::Terms terms = pawns::count_terms(entry.pawns, color);
+
+		// penalties count negative
+		features[DOUBLED] -= sign * terms.doubled;
+		features[ISOLATED] -= sign * terms.isolated;
+
+		for (int i = 0; i < pawns::NPASSED; ++i) {
+			features[PASSED + i] += sign * terms.passed[i];
+		}
+
+		if (const auto &king = kings[static_cast<size_t>(color)]) {
+			const pawns::Shield shield = pawns::count_shield(entry, color, *king);
+
+			features[SHIELD_NEAR] += sign * shield.near;
+			features[SHIELD_FAR] += sign * shield.far;
+		}
+
+		const attacks::Terms attack_terms = attacks::count_terms(map, color);
+
+		for (size_t i = 0; i < NMOBILITY; ++i) {
+			features[MOBILITY + i] += sign * attack_terms.mobility[i + 1];
+		}
+
+		for (size_t i = 0; i < NMATERIAL; ++i) {
+			features[KING_ATTACK + i] += sign * attack_terms.king_attacks[i + 1];
+		}
+
+		features[HANGING] -= sign * attack_terms.hanging;
+	}
+
+	Sample sample;
+
+	for (size_t i = 0; i < NWEIGHTS; ++i) {
+		sample.features[i] = clamp_feature(features[i]);
+	}
+
+	sample.result = result;
+	return sample;
+}
+
+static std::vector<Sample> load_samples(const char *path)
+{
+	std::ifstream is(path);
+
+	if (!is) {
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+
+	std::vector<Sample> samples;
+	std::string line;
+	size_t lineno = 0;
+
+	while (std::getline(is, line)) {
+		lineno += 1;
+
+		const size_t end = line.find_last_not_of(" \t\r;\"");
+
+		if (end == std::string::npos) {
+			continue;
+		}
+
+		const size_t begin = line.find_last_of(" \t\"", end);
+
+		if (begin == std::string::npos) {
+			fprintf(stderr, "lushin: tune: %s:%zu: missing result\n", path, lineno);
+			exit(EXIT_FAILURE);
+		}
+
+		try {
+			const uint8_t result = parse_result(line.substr(begin + 1, end - begin));
+			const Position position = chess::parse_fen(line.substr(0, begin));
+
+			samples.push_back(make_sample(position.board, result));
+		} catch (const std::exception &e) {
+			fprintf(stderr, "lushin: tune: %s:%zu: %s\n", path, lineno, e.what());
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return samples;
+}
+
+static void initial_weights(double *w)
+{
+	for (size_t i = 0; i < NMATERIAL; ++i) {
+		w[i] = weights::PIECE_VALUES[i + 1];
+	}
+
+	w[DOUBLED] = weights::DOUBLED_PENALTY;
+	w[ISOLATED] = weights::ISOLATED_PENALTY;
+
+	for (int i = 0; i < pawns::NPASSED; ++i) {
+		w[PASSED + i] = weights::PASSED_BONUS[i];
+	}
+
+	w[SHIELD_NEAR] = weights::SHIELD_NEAR_BONUS;
+	w[SHIELD_FAR] = weights::SHIELD_FAR_BONUS;
+
+	for (size_t i = 0; i < NMOBILITY; ++i) {
+		w[MOBILITY + i] = weights::MOBILITY_BONUS[i + 1];
+	}
+
+	for (size_t i = 0; i < NMATERIAL; ++i) {
+		w[KING_ATTACK + i] = weights::KING_ATTACK_BONUS[i + 1];
+	}
+
+	w[HANGING] = weights::HANGING_PENALTY;
+}
+
+/**
+ * Add the loss and gradient of samples [begin, end) to partial.
+ */
+static void compute_partial(const Sample *begin, const Sample *end, const double *w, double k, Partial &partial)
+{
+	partial.loss = 0;
+	std::fill(std::begin(partial.gradient), std::end(partial.gradient), 0.0);
+
+	for (const Sample *sample = begin; sample != end; ++sample) {
+		double eval = 0;
+
+		for (size_t i = 0; i < NWEIGHTS; ++i) {
+			eval += w[i] * sample->features[i];
+		}
+
+		const double predicted = 1 / (1 + std::exp(-k * eval));
+		const double error = predicted - sample->result / 2.0;
+
+		partial.loss += error * error;
+
+		// derivative of error^2 with respect to eval
+		const double slope = 2 * error * predicted * (1 - predicted) * k;
+
+		for (size_t i = 0; i < NWEIGHTS; ++i) {
+			partial.gradient[i] += slope * sample->features[i];
+		}
+	}
+}
+
+/**
+ * Runs compute_partial on all cores. Workers are started once
+ * and then only wait on barriers.
+ */
+class Pool
+{
+public:
+	Pool(const std::vector<Sample> &samples, size_t nthreads)
+		: m_samples(samples), m_partials(nthreads), m_start(nthreads + 1), m_done(nthreads + 1),
+		  m_weights(nullptr), m_k(0), m_quit(false)
+	{
+		for (size_t i = 0; i < nthreads; ++i) {
+			this->m_threads.emplace_back(&Pool::work, this, i);
+		}
+	}
+
+	~Pool()
+	{
+		this->m_quit = true;
+		this->m_start.wait();
+
+		for (std::thread &thread : this->m_threads) {
+			thread.join();
+		}
+	}
+
+	/**
+	 * Return the mean loss for weights w and write its gradient
+	 * into gradient.
+	 */
+	double run(const double *w, double k, double *gradient)
+	{
+		this->m_weights = w;
+		this->m_k = k;
+
+		this->m_start.wait();
+		this->m_done.wait();
+
+		double loss = 0;
+		std::fill(gradient, gradient + NWEIGHTS, 0.0);
+
+		for (const Partial &partial : this->m_partials) {
+			loss += partial.loss;
+
+			for (size_t i = 0; i < NWEIGHTS; ++i) {
+				gradient[i] += partial.gradient[i];
+			}
+		}
+
+		const double n = static_cast<double>(this->m_samples.size());
+
+		for (size_t i = 0; i < NWEIGHTS; ++i) {
+			gradient[i] /= n;
+		}
+
+		return loss / n;
+	}
+
+private:
+	const std::vector<Sample> &m_samples;
+	std::vector<Partial> m_partials;
+	std::vector<std::thread> m_threads;
+	Barrier m_start;
+	Barrier m_done;
+	const double *m_weights;
+	double m_k;
+	bool m_quit;
+
+	void work(size_t idx)
+	{
+		const size_t nthreads = this->m_partials.size();
+		const size_t n = this->m_samples.size();
+		const Sample *data = this->m_samples.data();
+
+		const Sample *begin = data + n * idx / nthreads;
+		const Sample *end = data + n * (idx + 1) / nthreads;
+
+		for (;;) {
+			this->m_start.wait();
+
+			if (this->m_quit) {
+				return;
+			}
+
+			compute_partial(begin, end, this->m_weights, this->m_k, this->m_partials[idx]);
+			this->m_done.wait();
+		}
+	}
+};
+
+/**
+ * Find the k for which the current weights fit the results best.
+ */
+static double fit_k(Pool &pool, const double *w)
+{
+	double gradient[NWEIGHTS];
+	double low = 0.0001;
+	double high = 0.05;
+
+	// golden section search; the loss has a single minimum in k
+	const double ratio = (std::sqrt(5.0) - 1) / 2;
+
+	for (int i = 0; i < 40; ++i) {
+		const double a = high - ratio * (high - low);
+		const double b = low + ratio * (high - low);
+
+		if (pool.run(w, a, gradient) < pool.run(w, b, gradient)) {
+			high = b;
+		} else {
+			low = a;
+		}
+	}
+
+	return (low + high) / 2;
+}
+
+static void write_weights(FILE *fp, const double *w)
+{
+	auto rounded = [&] (size_t i) {
+		return static_cast<int>(std::lround(w[i]));
+	};
+
+	fprintf(fp, "#pragma once\n\n");
+	fprintf(fp, "//\n");
+	fprintf(fp, "// Weights of the hand written evaluation in centipawns. This file\n");
+	fprintf(fp, "// can be regenerated from a set of labelled positions with\n");
+	fprintf(fp, "// lushin-tune.\n");
+	fprintf(fp, "//\n\n");
+	fprintf(fp, "namespace weights\n{\n");
+	fprintf(fp, "\t// indexed by chess::Kind\n");
+	fprintf(fp, "\tstatic constexpr int PIECE_VALUES[6] = {%d", weights::PIECE_VALUES[0]);
+
+	for (size_t i = 0; i < NMATERIAL; ++i) {
+		fprintf(fp, ", %d", rounded(i));
+	}
+
+	fprintf(fp, "};\n\n");
+	fprintf(fp, "\tstatic constexpr int DOUBLED_PENALTY = %d;\n", rounded(DOUBLED));
+	fprintf(fp, "\tstatic constexpr int ISOLATED_PENALTY = %d;\n\n", rounded(ISOLATED));
+	fprintf(fp, "\t// indexed by how many rows a passed pawn advanced from where\n");
+	fprintf(fp, "\t// pawns start\n");
+	fprintf(fp, "\tstatic constexpr int PASSED_BONUS[%d] = {", pawns::NPASSED);
+
+	for (int i = 0; i < pawns::NPASSED; ++i) {
+		fprintf(fp, "%s%d", i ? ", " : "", rounded(PASSED + i));
+	}
+
+	fprintf(fp, "};\n\n");
+	fprintf(fp, "\tstatic constexpr int SHIELD_NEAR_BONUS = %d;\n", rounded(SHIELD_NEAR));
+	fprintf(fp, "\tstatic constexpr int SHIELD_FAR_BONUS = %d;\n\n", rounded(SHIELD_FAR));
+	fprintf(fp, "\t// per safe cell a piece attacks, indexed by chess::Kind\n");
+	fprintf(fp, "\tstatic constexpr int MOBILITY_BONUS[6] = {%d", weights::MOBILITY_BONUS[0]);
+
+	for (size_t i = 0; i < NMOBILITY; ++i) {
+		fprintf(fp, ", %d", rounded(MOBILITY + i));
+	}
+
+	fprintf(fp, ", %d};\n\n", weights::MOBILITY_BONUS[5]);
+	fprintf(fp, "\t// per cell around the enemy king attacked, indexed by\n");
+	fprintf(fp, "\t// chess::Kind\n");
+	fprintf(fp, "\tstatic constexpr int KING_ATTACK_BONUS[6] = {%d", weights::KING_ATTACK_BONUS[0]);
+
+	for (size_t i = 0; i < NMATERIAL; ++i) {
+		fprintf(fp, ", %d", rounded(KING_ATTACK + i));
+	}
+
+	fprintf(fp, "};\n\n");
+	fprintf(fp, "\tstatic constexpr int HANGING_PENALTY = %d;\n", rounded(HANGING));
+	fprintf(fp, "};\n");
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr, "usage: %s [-t THREADS] [-n ITERATIONS] [-o OUTPUT] DATASET\n", argv0);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+	size_t niterations = 1000;
+	const char *output = nullptr;
+	const char *dataset = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+			nthreads = std::max(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+			niterations = std::max(0, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			output = argv[++i];
+		} else if (argv[i][0] == '-' || dataset) {
+			usage(argv[0]);
+		} else {
+			dataset = argv[i];
+		}
+	}
+
+	if (!dataset) {
+		usage(argv[0]);
+	}
+
+	const std::vector<Sample> samples = load_samples(dataset);
+
+	if (samples.empty()) {
+		fprintf(stderr, "lushin: tune: %s: no positions\n", dataset);
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(stderr, "loaded %zu positions, tuning on %zu threads\n", samples.size(), nthreads);
+
+	double w[NWEIGHTS];
+	double gradient[NWEIGHTS];
+	double m[NWEIGHTS] = {};
+	double v[NWEIGHTS] = {};
+
+	initial_weights(w);
+
+	Pool pool(samples, nthreads);
+	const double k = fit_k(pool, w);
+
+	fprintf(stderr, "k = %g\n", k);
+
+	for (size_t t = 1; t <= niterations; ++t) {
+		const double loss = pool.run(w, k, gradient);
+
+		if (t == 1 || t % 100 == 0) {
+			fprintf(stderr, "iteration %zu: loss %.8f\n", t, loss);
+		}
+
+		for (size_t i = 0; i < NWEIGHTS; ++i) {
+			m[i] = BETA1 * m[i] + (1 - BETA1) * gradient[i];
+			v[i] = BETA2 * v[i] + (1 - BETA2) * gradient[i] * gradient[i];
+
+			const double m_hat = m[i] / (1 - std::pow(BETA1, t));
+			const double v_hat = v[i] / (1 - std::pow(BETA2, t));
+
+			w[i] -= LEARNING_RATE * m_hat / (std::sqrt(v_hat) + EPSILON);
+		}
+	}
+
+	FILE *fp = output ? fopen(output, "w") : stdout;
+
+	if (!fp) {
+		perror(output);
+		exit(EXIT_FAILURE);
+	}
+
+	write_weights(fp, w);
+
+	if (output && fclose(fp)) {
+		perror(output);
+		exit(EXIT_FAILURE);
+	}
+}
@@ -1,31 +1,22 @@
+#include "arena.hh"
 #include "chess.hh"
 
 using namespace chess;
 
 std::vector<Board> chess::valid_next_boards(const Board &board, Color current_player)
 {
-	std::vector<Board> next_boards;
-
-	board.for_each([&] (const Pos &pos, const Piece &piece) {
-		if (!piece.present) {
-			return;
-		}
-
-		if (piece.color != current_player) {
-			return;
-		}
+	arena::Frame frame;
+	const arena::MoveList moves = frame.moves(board, current_player);
 
-		const auto nexts = chess::valid_next_positions(board, pos);
-
-		for (const Pos &to : nexts) {
-			const Pos &from = pos;
+	std::vector<Board> next_boards;
+	next_boards.reserve(moves.size());
 
-			Board next_board = board;
-			next_board.move(from, to);
+	for (const Move &move : moves) {
+		Board next_board = board;
+		next_board.move(move.from, move.to);
 
-			next_boards.push_back(next_board);
-		}
-	});
+		next_boards.push_back(next_board);
+	}
 
 	return next_boards;
 }
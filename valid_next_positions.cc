@@ -1,15 +1,42 @@
 #include "chess.hh"
 
+#include <cassert>
 #include <stdexcept>
 
 using namespace chess;
 
-static std::vector<Pos> moves_from_diff(const Board &board, const Piece &piece, const Pos &at, const std::vector<Pos> &diffs)
+/**
+ * Caller provided buffer the helpers below append positions to.
+ * This way computing moves never has to allocate.
+ */
+struct Positions
 {
-	std::vector<Pos> output;
+	const Board &board;
+	Targets targets;
+	Pos *out;
+	size_t size;
 
-	for (const Pos &diff : diffs) {
-		const Pos actual = at + diff;
+	void push_back(const Pos &pos)
+	{
+		assert(this->size < MAX_NEXT_POSITIONS);
+
+		if (this->targets != Targets::All) {
+			const bool captures = this->board.at(pos).present;
+			const bool want_captures = this->targets == Targets::Captures;
+
+			if (captures != want_captures) {
+				return;
+			}
+		}
+
+		this->out[this->size++] = pos;
+	}
+};
+
+static void moves_from_diff(const Board &board, const Piece &piece, const Pos &at, const Pos *diffs, size_t ndiffs, Positions &output)
+{
+	for (size_t i = 0; i < ndiffs; ++i) {
+		const Pos actual = at + diffs[i];
 
 		if (!actual.on_board()) {
 			continue;
@@ -21,24 +48,20 @@ static std::vector<Pos> moves_from_diff(const Board &board, const Piece &piece,
 			output.push_back(actual);
 		}
 	}
-
-	return output;
 }
 
-static std::vector<Pos> valid_next_king_positions(const Board &board, const Piece &piece, const Pos &from)
+static void valid_next_king_positions(const Board &board, const Piece &piece, const Pos &from, Positions &output)
 {
-	static const std::vector<Pos> diff = {
+	static const Pos diff[] = {
 		{1, 0}, {0, 1}, {-1, 0}, {0, -1},
 		{1, 1}, {1, -1}, {-1, 1}, {-1, -1}
 	};
 
-	return moves_from_diff(board, piece, from, diff);
+	moves_from_diff(board, piece, from, diff, 8, output);
 }
 
-static std::vector<Pos> reachable_by_travel(const Board &board, const Piece &piece, const Pos &start, const Pos& direction)
+static void reachable_by_travel(const Board &board, const Piece &piece, const Pos &start, const Pos& direction, Positions &output)
 {
-	std::vector<Pos> output;
-
 	Pos current = start + direction;
 
 	while (current.on_board()) {
@@ -55,63 +78,44 @@ static std::vector<Pos> reachable_by_travel(const Board &board, const Piece &pie
 		output.push_back(current);
 		current += direction;
 	}
-
-	return output;
 }
 
-static std::vector<Pos> valid_next_rook_positions(const Board &board, const Piece &piece, const Pos &from)
+static void valid_next_rook_positions(const Board &board, const Piece &piece, const Pos &from, Positions &output)
 {
-	static const std::vector<Pos> directions = {
+	static const Pos directions[] = {
 		{1, 0}, {0, 1}, {-1, 0}, {0, -1}
 	};
 
-	std::vector<Pos> output;
-
 	for (const Pos &direction : directions) {
-		const std::vector<Pos> reachable = reachable_by_travel(board, piece, from, direction);
-		output.insert(end(output), begin(reachable), end(reachable));
+		reachable_by_travel(board, piece, from, direction, output);
 	}
-
-	return output;
 }
 
-static std::vector<Pos> valid_next_bishop_positions(const Board &board, const Piece &piece, const Pos &from)
+static void valid_next_bishop_positions(const Board &board, const Piece &piece, const Pos &from, Positions &output)
 {
-	static const std::vector<Pos> directions = {
+	static const Pos directions[] = {
 		{1, 1}, {1, -1}, {-1, -1}, {-1, 1}
 	};
 
-	std::vector<Pos> output;
-
 	for (const Pos &direction : directions) {
-		const std::vector<Pos> reachable = reachable_by_travel(board, piece, from, direction);
-		output.insert(end(output), begin(reachable), end(reachable));
+		reachable_by_travel(board, piece, from, direction, output);
 	}
-
-	return output;
 }
 
-static std::vector<Pos> valid_next_queen_positions(const Board &board, const Piece &piece, const Pos &from)
+static void valid_next_queen_positions(const Board &board, const Piece &piece, const Pos &from, Positions &output)
 {
-	std::vector<Pos> output;
-
-	const std::vector<Pos> rook_moves = valid_next_rook_positions(board, piece, from);
-	output.insert(end(output), begin(rook_moves), end(rook_moves));
-
-	const std::vector<Pos> bishop_moves = valid_next_bishop_positions(board, piece, from);
-	output.insert(end(output), begin(bishop_moves), end(bishop_moves));
-
-	return output;
+	valid_next_rook_positions(board, piece, from, output);
+	valid_next_bishop_positions(board, piece, from, output);
 }
 
-static std::vector<Pos> valid_next_knight_positions(const Board &board, const Piece &piece, const Pos &from)
+static void valid_next_knight_positions(const Board &board, const Piece &piece, const Pos &from, Positions &output)
 {
-	static const std::vector<Pos> diff = {
+	static const Pos diff[] = {
 		{1, 2}, {2, 1}, {2, -1}, {1, -2},
 		{-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
 	};
 
-	return moves_from_diff(board, piece, from, diff);
+	moves_from_diff(board, piece, from, diff, 8, output);
 }
 
 static bool is_initial_pawn(const Piece &piece, const Pos &at)
@@ -139,10 +143,8 @@ static bool is_empty(const Board &b, const Pos &at)
 	return !piece.present;
 }
 
-static std::vector<Pos> valid_next_pawn_positions(const Board &board, const Piece &piece, const Pos &from)
+static void valid_next_pawn_positions(const Board &board, const Piece &piece, const Pos &from, Positions &pawn_moves)
 {
-	std::vector<Pos> pawn_moves;
-
 	int sign = piece.color == Color::White ? -1 : 1;
 
 	const Pos regular_move = Pos(0, sign) + from;
@@ -150,11 +152,15 @@ static std::vector<Pos> valid_next_pawn_positions(const Board &board, const Piec
 	const Pos capture_left  = Pos(-1, sign) + from;
 	const Pos capture_right = Pos(1, sign) + from;
 
-	if (regular_move.on_board() && is_empty(board, regular_move)) {
+	// pawns never capture going straight, skip those checks
+	// entirely when only captures were asked for
+	const bool wants_quiets = pawn_moves.targets != Targets::Captures;
+
+	if (wants_quiets && regular_move.on_board() && is_empty(board, regular_move)) {
 		pawn_moves.push_back(regular_move);
 	}
 
-	if (double_move.on_board() && is_initial_pawn(piece, from) && is_empty(board, double_move)) {
+	if (wants_quiets && double_move.on_board() && is_initial_pawn(piece, from) && is_empty(board, double_move)) {
 		pawn_moves.push_back(double_move);
 	}
 
@@ -165,32 +171,47 @@ static std::vector<Pos> valid_next_pawn_positions(const Board &board, const Piec
 	if (capture_right.on_board() && !is_empty(board, capture_right) && can_take_place_of(piece, board.at(capture_right))) {
 		pawn_moves.push_back(capture_right);
 	}
-
-	return pawn_moves;
 }
 
-std::vector<Pos> chess::valid_next_positions(const Board &board, const Pos &from)
+size_t chess::next_positions(const Board &board, const Pos &from, Pos *out, Targets targets)
 {
 	const Piece &piece = board.at(from);
+	Positions output = {board, targets, out, 0};
 
 	if (!piece.present) {
-		return {};
+		return 0;
 	}
 
 	switch (piece.kind) {
 	case Kind::King:
-		return valid_next_king_positions(board, piece, from);
+		valid_next_king_positions(board, piece, from, output);
+		break;
 	case Kind::Queen:
-		return valid_next_queen_positions(board, piece, from);
+		valid_next_queen_positions(board, piece, from, output);
+		break;
 	case Kind::Rook:
-		return valid_next_rook_positions(board, piece, from);
+		valid_next_rook_positions(board, piece, from, output);
+		break;
 	case Kind::Bishop:
-		return valid_next_bishop_positions(board, piece, from);
+		valid_next_bishop_positions(board, piece, from, output);
+		break;
 	case Kind::Knight:
-		return valid_next_knight_positions(board, piece, from);
+		valid_next_knight_positions(board, piece, from, output);
+		break;
 	case Kind::Pawn:
-		return valid_next_pawn_positions(board, piece, from);
+		valid_next_pawn_positions(board, piece, from, output);
+		break;
 	default:
 		throw std::invalid_argument("bad value for Kind enum");
 	}
+
+	return output.size;
+}
+
+std::vector<Pos> chess::valid_next_positions(const Board &board, const Pos &from)
+{
+	Pos buf[MAX_NEXT_POSITIONS];
+	const size_t n = chess::next_positions(board, from, buf);
+
+	return std::vector<Pos>(buf, buf + n);
 }
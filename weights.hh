@@ -0,0 +1,32 @@
+#pragma once
+
+//
+// Weights of the hand written evaluation in centipawns. This file
+// can be regenerated from a set of labelled positions with
+// lushin-tune.
+//
+
+namespace weights
+{
+	// indexed by chess::Kind
+	static constexpr int PIECE_VALUES[6] = {1800, 900, 500, 300, 300, 100};
+
+	static constexpr int DOUBLED_PENALTY = 15;
+	static constexpr int ISOLATED_PENALTY = 12;
+
+	// indexed by how many rows a passed pawn advanced from where
+	// pawns start
+	static constexpr int PASSED_BONUS[7] = {0, 10, 20, 35, 60, 100, 150};
+
+	static constexpr int SHIELD_NEAR_BONUS = 15;
+	static constexpr int SHIELD_FAR_BONUS = 8;
+
+	// per safe cell a piece attacks, indexed by chess::Kind
+	static constexpr int MOBILITY_BONUS[6] = {0, 1, 2, 4, 4, 0};
+
+	// per cell around the enemy king attacked, indexed by
+	// chess::Kind
+	static constexpr int KING_ATTACK_BONUS[6] = {0, 6, 4, 3, 3, 2};
+
+	static constexpr int HANGING_PENALTY = 10;
+};
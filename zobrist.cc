@@ -0,0 +1,58 @@
+#include <array>
+
+#include "chess.hh"
+
+using namespace chess;
+
+/**
+ * One key per color, kind and cell plus one key for whose turn
+ * it is.
+ */
+static constexpr size_t NKEYS = 2 * 6 * 64 + 1;
+
+/**
+ * Return the next value of the splitmix64 generator with given
+ * state. Good enough to fill the table with keys at compile time.
+ */
+static constexpr uint64_t splitmix64(uint64_t &state)
+{
+	state += 0x9e3779b97f4a7c15ULL;
+
+	uint64_t z = state;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+static constexpr std::array<uint64_t, NKEYS> make_keys()
+{
+	std::array<uint64_t, NKEYS> keys = {};
+	uint64_t state = 0x6c7573686e696e00ULL;
+
+	for (size_t i = 0; i < NKEYS; ++i) {
+		keys[i] = splitmix64(state);
+	}
+
+	return keys;
+}
+
+static constexpr std::array<uint64_t, NKEYS> KEYS = make_keys();
+
+uint64_t chess::zobrist_key(const Pos &pos, const Piece &piece)
+{
+	const size_t color = static_cast<size_t>(piece.color);
+	const size_t kind = static_cast<size_t>(piece.kind);
+	const size_t cell = pos.x + pos.y * 8;
+
+	return KEYS[(color * 6 + kind) * 64 + cell];
+}
+
+uint64_t chess::zobrist_key(Color current_player)
+{
+	if (current_player == Color::Black) {
+		return KEYS[NKEYS - 1];
+	} else {
+		return 0;
+	}
+}